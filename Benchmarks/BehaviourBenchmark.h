@@ -0,0 +1,209 @@
+#ifndef BEHAVIOURBENCHMARK_H_INCLUDED
+#define BEHAVIOURBENCHMARK_H_INCLUDED
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <memory>
+#include <functional>
+
+#include "Benchmark.h"
+#include "PathBenchmark.h"
+#include "Systems/System.h"
+#include "BehaviourManager.h"
+
+// Agents with everything every behaviour needs, obstacles, walls and a patrol route. ObstacleGrid, WallBVH,
+// Neighbourhood and local frames are built once, as the systems would do before AISteeringSystem runs.
+struct BehaviourWorld {
+    BehaviourWorld(int agentsCount, int obstaclesCount) {
+        srand48(42);
+
+        worldSize = std::sqrt(float(std::max(agentsCount, obstaclesCount))) * 60.0f;
+        auto randomPosition = [&]() { return glm::vec2(drand48() * worldSize, drand48() * worldSize); };
+
+        createObstacles(registry, obstaclesCount, worldSize);
+
+        for(int i = 0; i < std::max(16, obstaclesCount / 16); ++i) {
+            glm::vec2 start = randomPosition();
+            registry.assign<Wall>(registry.create(), Line2D{start, start + glm::vec2(drand48() * 200.0f - 100.0f, drand48() * 200.0f - 100.0f)},
+                                  SDL_Color{0, 255, 0, 255});
+        }
+
+        auto route = std::make_shared<SegmentedPath>();
+        route->setPath(generatePatrolRoute(200));
+        path = registry.create();
+        registry.assign<Path>(path, route, false);
+
+        leader = createAgent(randomPosition());
+        second = createAgent(randomPosition());
+
+        Waypoints waypoints;
+        for(int i = 0; i < 8; ++i) waypoints.push_back(randomPosition());
+        WaypointsPath patrol(waypoints, 25.0f, true);    // every agent shares the waypoints
+
+        for(int i = 0; i < agentsCount; ++i) {
+            entt::entity agent = createAgent(randomPosition());
+            registry.assign<PathCursor>(agent);
+
+            registry.assign<AI>(agent, leader);
+            registry.assign<WanderState>(agent, entt::to_integral(agent));
+            registry.assign<WaypointsPath>(agent, patrol);
+            managers.emplace_back(&registry, agent);
+            agents.push_back(agent);
+        }
+
+        for(ISystem* system: std::initializer_list<ISystem*>{&obstacleGrid, &wallBVH, &neighbourhood, &localFrames}) {
+            system->enter(registry, dispatcher);
+            system->update(registry, dispatcher, 0.0f);
+        }
+    }
+
+    // Avoidance, pursuit and the expensive hide and wander, with weights as in a typical agent
+    SteeringSettings allBehaviours(SteeringSettings::CombinationMode mode) const {
+        SteeringSettings settings;
+        settings.mode = mode;
+        settings.enable(SteeringSettings::WALL_AVOIDANCE);
+        settings.enable(SteeringSettings::OBSTACLE_AVOIDANCE);
+        settings.enable(SteeringSettings::OFFSET_PURSUIT, 0.5f);
+        settings.enable(SteeringSettings::HIDE, 0.5f);
+        settings.enable(SteeringSettings::WANDER, 0.3f);
+        return settings;
+    }
+
+    void setSettings(const SteeringSettings& settings) {
+        for(auto agent: agents) registry.get<AI>(agent).settings = settings;
+    }
+
+    entt::entity createAgent(glm::vec2 position) {
+        glm::vec2 velocity = glm::vec2(drand48() * 200.0f - 100.0f, drand48() * 200.0f - 100.0f);
+
+        entt::entity agent = registry.create();
+        registry.assign<Transform>(agent, position, glm::vec2(32.0f, 32.0f), 1.0f, vecToOrientation(velocity));
+        registry.assign<Physics>(agent, 150.0f, 1.0f, 200.0f, 100.0f, 20.0f).velocity = velocity;
+        registry.assign<Kinematic>(agent, 150.0f, 200.0f, 100.0f).velocity = velocity;
+
+        return agent;
+    }
+
+    entt::registry              registry;
+    entt::dispatcher            dispatcher;
+    float                       worldSize;
+
+    std::vector<entt::entity>   agents;
+    std::vector<SteeringManager> managers;
+    entt::entity                leader;
+    entt::entity                second;
+    entt::entity                path;
+
+    ObstacleGridSystem          obstacleGrid;
+    WallBVHSystem               wallBVH;
+    NeighbourhoodSystem         neighbourhood;
+    LocalFrameSystem            localFrames;
+};
+
+struct BehaviourCase {
+    const char*                                 name;
+    std::function<glm::vec2(BehaviourWorld&, std::size_t)> evaluate;     // agent index -> force
+    std::function<void(BehaviourWorld&)>        prepare;                    // optional, run before the timing
+};
+
+std::vector<BehaviourCase> getBehaviourCases() {
+    auto position = [](BehaviourWorld& world, entt::entity entity) { return world.registry.get<Transform>(entity).position; };
+    auto linear = [](sb::Output output) { return output.acceleration + glm::vec2(output.angular, 0.0f); };
+    auto kinematic = [](ksb::Output output) { return output.velocity + glm::vec2(output.orientation, 0.0f); };
+
+    return {
+        {"SteeringManager::seek", [=](BehaviourWorld& w, std::size_t i) { return w.managers[i].seek(position(w, w.leader)); }},
+        {"SteeringManager::flee", [=](BehaviourWorld& w, std::size_t i) { return w.managers[i].flee(position(w, w.leader)); }},
+        {"SteeringManager::arrive", [=](BehaviourWorld& w, std::size_t i) {
+            return w.managers[i].arrive(position(w, w.leader), SteeringManager::MEDIUM); }},
+        {"SteeringManager::pursuit", [](BehaviourWorld& w, std::size_t i) { return w.managers[i].pursuit(w.leader); }},
+        {"SteeringManager::evade", [](BehaviourWorld& w, std::size_t i) { return w.managers[i].evade(w.leader); }},
+        {"SteeringManager::wander", [](BehaviourWorld& w, std::size_t i) { return w.managers[i].wander(); }},
+        {"SteeringManager::obstacleAvoiding2", [](BehaviourWorld& w, std::size_t i) { return w.managers[i].obstacleAvoiding2(); }},
+        {"SteeringManager::wallAvoidance", [](BehaviourWorld& w, std::size_t i) { return w.managers[i].wallAvoidance(); }},
+        {"SteeringManager::interpose", [](BehaviourWorld& w, std::size_t i) { return w.managers[i].interpose(w.leader, w.second); }},
+        {"SteeringManager::hide", [](BehaviourWorld& w, std::size_t i) { return w.managers[i].hide(w.leader); }},
+        {"SteeringManager::followPath", [](BehaviourWorld& w, std::size_t i) { return w.managers[i].followPath(); }},
+        {"SteeringManager::offsetPursuit", [](BehaviourWorld& w, std::size_t i) {
+            return w.managers[i].offsetPursuit(w.leader, glm::vec2(-48.0f, -48.0f)); }},
+        {"SteeringManager::calculate weighted", [](BehaviourWorld& w, std::size_t i) { return w.managers[i].calculate(); },
+         [](BehaviourWorld& w) { w.setSettings(w.allBehaviours(SteeringSettings::WEIGHTED_SUM)); }},
+        {"SteeringManager::calculate prioritised", [](BehaviourWorld& w, std::size_t i) { return w.managers[i].calculate(); },
+         [](BehaviourWorld& w) { w.setSettings(w.allBehaviours(SteeringSettings::PRIORITISED)); }},
+
+        {"sb::seek", [=](BehaviourWorld& w, std::size_t i) { return linear(sb::seek(w.registry, w.agents[i], position(w, w.leader))); }},
+        {"sb::flee", [=](BehaviourWorld& w, std::size_t i) { return linear(sb::flee(w.registry, w.agents[i], position(w, w.leader), 300.0f)); }},
+        {"sb::arrive", [=](BehaviourWorld& w, std::size_t i) {
+            return linear(sb::arrive(w.registry, w.agents[i], position(w, w.leader), 1.0f, 300.0f)); }},
+        {"sb::align", [=](BehaviourWorld& w, std::size_t i) { return linear(sb::align(w.registry, w.agents[i], 90.0f, 0.1f, 10.0f)); }},
+        {"sb::velocityMatch", [=](BehaviourWorld& w, std::size_t i) {
+            return linear(sb::velocityMatch(w.registry, w.agents[i], glm::vec2(50.0f, 0.0f))); }},
+        {"sb::pursue", [=](BehaviourWorld& w, std::size_t i) { return linear(sb::pursue(w.registry, w.agents[i], w.leader, 1.0f)); }},
+        {"sb::evade", [=](BehaviourWorld& w, std::size_t i) { return linear(sb::evade(w.registry, w.agents[i], w.leader, 1.0f)); }},
+        {"sb::face", [=](BehaviourWorld& w, std::size_t i) { return linear(sb::face(w.registry, w.agents[i], w.leader)); }},
+        {"sb::lookAtMovingDirection", [=](BehaviourWorld& w, std::size_t i) {
+            return linear(sb::lookAtMovingDirection(w.registry, w.agents[i])); }},
+        {"sb::followPath", [=](BehaviourWorld& w, std::size_t i) { return linear(sb::followPath(w.registry, w.agents[i], w.path)); }},
+        {"sb::followPredictedPath", [=](BehaviourWorld& w, std::size_t i) {
+            return linear(sb::followPredictedPath(w.registry, w.agents[i], 0.5f, w.path)); }},
+        {"sb::separation", [=](BehaviourWorld& w, std::size_t i) { return linear(sb::separation(w.registry, w.agents[i], 5000.0f, 60.0f)); }},
+        {"sb::collisionAvoidance", [=](BehaviourWorld& w, std::size_t i) {
+            return linear(sb::collisionAvoidance(w.registry, w.agents[i], 40.0f)); }},
+
+        {"ksb::seek", [=](BehaviourWorld& w, std::size_t i) { return kinematic(ksb::seek(w.registry, w.agents[i], position(w, w.leader))); }},
+        {"ksb::flee", [=](BehaviourWorld& w, std::size_t i) {
+            return kinematic(ksb::flee(w.registry, w.agents[i], position(w, w.leader), 300.0f)); }},
+        {"ksb::arrive", [=](BehaviourWorld& w, std::size_t i) {
+            return kinematic(ksb::arrive(w.registry, w.agents[i], position(w, w.leader), 25.0f)); }},
+        {"ksb::wandering", [=](BehaviourWorld& w, std::size_t i) { return kinematic(ksb::wandering(w.registry, w.agents[i], 30.0f)); }},
+    };
+}
+
+// ns per agent-evaluation of every behaviour, best of 7 runs. A run calls it for every agent until at least
+// 50000 calls were made, so small worlds aren't timed in microseconds. Behaviours with state (wander, followPath) keep advancing it between runs, as they would in game.
+std::vector<BenchmarkResult> benchmarkBehaviours() {
+    struct Size { int agents; int obstacles; };
+    const Size sizes[] = {{1000, 100}, {1000, 10000}, {10000, 1000}};
+
+    std::vector<BehaviourCase> cases = getBehaviourCases();
+    std::vector<BenchmarkResult> results;
+
+    printf("Steering behaviours, ns per agent-evaluation\n");
+    printf("%-40s", "behaviour");
+    for(const Size& size: sizes) printf("   %6d/%-6d", size.agents, size.obstacles);
+    printf("\n");
+
+    std::vector<std::unique_ptr<BehaviourWorld>> worlds;
+    for(const Size& size: sizes) worlds.emplace_back(new BehaviourWorld(size.agents, size.obstacles));
+
+    volatile float sink = 0.0f;
+    for(const BehaviourCase& behaviour: cases) {
+        printf("%-40s", behaviour.name);
+
+        for(auto s = 0u; s < worlds.size(); ++s) {
+            BehaviourWorld& world = *worlds[s];
+
+            std::size_t passes = (50000 + world.agents.size() - 1) / world.agents.size();
+            if(behaviour.prepare) behaviour.prepare(world);
+
+            glm::vec2 sum = glm::vec2(0.0f, 0.0f);
+            double milliseconds = measureMilliseconds([&]() {
+                for(std::size_t pass = 0; pass < passes; ++pass)
+                    for(std::size_t i = 0; i < world.agents.size(); ++i) sum += behaviour.evaluate(world, i);
+            }, 7);
+            sink = sink + sum.x + sum.y;
+
+            double nsPerEvaluation = milliseconds * 1e6 / (world.agents.size() * passes);
+            results.push_back(BenchmarkResult{behaviour.name, sizes[s].agents, sizes[s].obstacles, nsPerEvaluation});
+            printf(" %15.1f", nsPerEvaluation);
+        }
+
+        printf("\n");
+    }
+
+    return results;
+}
+
+#endif // BEHAVIOURBENCHMARK_H_INCLUDED
@@ -0,0 +1,183 @@
+#ifndef BENCHMARK_H_INCLUDED
+#define BENCHMARK_H_INCLUDED
+
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cmath>
+#include <cstdlib>
+
+#include "entt.hpp"
+#include "glm/glm.hpp"
+#include "Components/Components.h"
+
+// Best of several runs in milliseconds - we care about the code, not about the scheduler noise
+template<typename Function>
+double measureMilliseconds(Function function, int runs = 5) {
+    double best = 0.0;
+    for(int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        best = (i == 0) ? elapsed.count() : std::min(best, elapsed.count());
+    }
+
+    return best;
+}
+
+// Side of a square world giving every one of count items spacing x spacing pixels, so density stays constant
+inline float constantDensityWorldSize(int count, float spacing) {
+    return std::sqrt(float(count)) * spacing;
+}
+
+// From drand48(), every benchmark seeds it
+inline glm::vec2 randomPosition(float worldSize) {
+    return glm::vec2(drand48() * worldSize, drand48() * worldSize);
+}
+
+// Static obstacles with radius 15-30 scattered over the world
+inline void createObstacles(entt::registry& registry, int count, float worldSize) {
+    for(int i = 0; i < count; ++i) {
+        entt::entity obstacle = registry.create();
+        registry.assign<Transform>(obstacle, randomPosition(worldSize), glm::vec2(0.0f, 0.0f), 1.0f, 0.0f);
+        registry.assign<Physics>(obstacle, 1.0f, 1.0f, 1.0f, 1.0f, drand48() * 15.0f + 15.0f);
+        registry.assign<Obstacle>(obstacle, SDL_Color{0, 255, 0, 255});
+    }
+}
+
+// Agent standing at position, with the Physics every steering benchmark uses
+inline entt::entity createAgent(entt::registry& registry, glm::vec2 position) {
+    entt::entity agent = registry.create();
+    registry.assign<Transform>(agent, position, glm::vec2(32.0f, 32.0f), 1.0f, 0.0f);
+    registry.assign<Physics>(agent, 150.0f, 1.0f, 200.0f, 100.0f, 20.0f);
+    return agent;
+}
+
+// The same count forces computed by brute force and by queries of the structure a system builds.
+// Mismatch = relative difference above 1e-3, NaN included.
+struct BruteVsGrid {
+    double  bruteMilliseconds;
+    double  buildMilliseconds;
+    double  queryMilliseconds;
+    int     mismatches;
+};
+
+// brute(i) and query(i) return the force of item i, brute runs in order for i = 0..count-1 bruteRuns times.
+// The system enters the registry after the brute force run, its update() is the build.
+template<typename Brute, typename System, typename Query>
+BruteVsGrid compareBruteWithGrid(int count, Brute brute, entt::registry& registry, System& system, Query query,
+                                 int bruteRuns = 5) {
+    std::vector<glm::vec2> bruteForces(count), gridForces(count);
+    BruteVsGrid result;
+
+    result.bruteMilliseconds = measureMilliseconds([&]() {
+        for(int i = 0; i < count; ++i) bruteForces[i] = brute(i);
+    }, bruteRuns);
+
+    entt::dispatcher dispatcher;
+    system.enter(registry, dispatcher);
+    result.buildMilliseconds = measureMilliseconds([&]() {
+        system.update(registry, dispatcher, 0.0f);
+    });
+    result.queryMilliseconds = measureMilliseconds([&]() {
+        for(int i = 0; i < count; ++i) gridForces[i] = query(i);
+    });
+
+    result.mismatches = 0;
+    for(int i = 0; i < count; ++i) {
+        if(!(glm::distance(bruteForces[i], gridForces[i]) <= 1e-3f * std::max(1.0f, glm::length(bruteForces[i])))) {
+            result.mismatches++;
+        }
+    }
+
+    return result;
+}
+
+void printBruteVsGridHeader(const char* sizeName, const char* bruteName) {
+    printf("%10s %12s %12s %12s %10s %10s\n", sizeName, bruteName, "build(ms)", "query(ms)", "speedup", "mismatch");
+}
+
+void printBruteVsGrid(int size, const BruteVsGrid& result) {
+    printf("%10d %12.3f %12.3f %12.3f %9.1fx %10d\n", size, result.bruteMilliseconds, result.buildMilliseconds,
+           result.queryMilliseconds, result.bruteMilliseconds / (result.buildMilliseconds + result.queryMilliseconds),
+           result.mismatches);
+}
+
+// One measurement for the JSON report, identified by name and problem size
+struct BenchmarkResult {
+    std::string name;
+    int         agents;
+    int         obstacles;
+    double      nsPerEvaluation;
+};
+
+// One result per line, so compareWithBaseline() can read the file back without a JSON library
+bool writeResultsJson(const std::vector<BenchmarkResult>& results, const std::string& fileName) {
+    FILE* file = fopen(fileName.c_str(), "w");
+    if(file == nullptr) return false;
+
+    fprintf(file, "{\"benchmarks\": [\n");
+    for(auto i = 0u; i < results.size(); ++i) {
+        const BenchmarkResult& result = results[i];
+        fprintf(file, "{\"name\": \"%s\", \"agents\": %d, \"obstacles\": %d, \"ns_per_eval\": %.3f}%s\n", result.name.c_str(),
+                result.agents, result.obstacles, result.nsPerEvaluation, (i + 1 < results.size()) ? "," : "");
+    }
+    fprintf(file, "]}\n");
+
+    fclose(file);
+    return true;
+}
+
+// Reads a file written by writeResultsJson()
+bool readResultsJson(const std::string& fileName, std::vector<BenchmarkResult>& results) {
+    FILE* file = fopen(fileName.c_str(), "r");
+    if(file == nullptr) return false;
+
+    char line[512];
+    while(fgets(line, sizeof(line), file) != nullptr) {
+        char name[256];
+        BenchmarkResult result;
+        if(sscanf(line, "{\"name\": \"%255[^\"]\", \"agents\": %d, \"obstacles\": %d, \"ns_per_eval\": %lf",
+                  name, &result.agents, &result.obstacles, &result.nsPerEvaluation) == 4) {
+            result.name = name;
+            results.push_back(result);
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+
+// Prints every result next to its baseline, returns the number of results slower than the baseline
+// by more than thresholdPercent
+int compareWithBaseline(const std::vector<BenchmarkResult>& results, const std::vector<BenchmarkResult>& baseline,
+                        double thresholdPercent) {
+    printf("%-40s %8s %10s %14s %14s %10s\n", "benchmark", "agents", "obstacles", "baseline(ns)", "current(ns)", "change");
+
+    int regressions = 0;
+    for(const auto& result: results) {
+        auto found = std::find_if(baseline.begin(), baseline.end(), [&](const BenchmarkResult& old) {
+            return old.name == result.name && old.agents == result.agents && old.obstacles == result.obstacles;
+        });
+
+        if(found == baseline.end()) {
+            printf("%-40s %8d %10d %14s %14.1f %10s\n", result.name.c_str(), result.agents, result.obstacles, "-",
+                   result.nsPerEvaluation, "new");
+            continue;
+        }
+
+        double change = (result.nsPerEvaluation / found->nsPerEvaluation - 1.0) * 100.0;
+        bool regression = change > thresholdPercent;
+        regressions += regression;
+
+        printf("%-40s %8d %10d %14.1f %14.1f %+9.1f%%%s\n", result.name.c_str(), result.agents, result.obstacles,
+               found->nsPerEvaluation, result.nsPerEvaluation, change, regression ? "  REGRESSION" : "");
+    }
+
+    return regressions;
+}
+
+#endif // BENCHMARK_H_INCLUDED
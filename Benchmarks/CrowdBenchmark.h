@@ -0,0 +1,155 @@
+#ifndef CROWDBENCHMARK_H_INCLUDED
+#define CROWDBENCHMARK_H_INCLUDED
+
+#include <cstdio>
+#include <chrono>
+#include <vector>
+#include <thread>
+
+#include "Benchmark.h"
+#include "BehaviourManager.h"
+#include "Systems/System.h"
+
+// Two blocks of agents walking head-on through each other. sb::collisionAvoidance steers with Neighbourhood
+// neighbours (velocity matching to the preferred velocity plus the avoidance acceleration), ORCA replaces the
+// velocity by OrcaSystem's. Overlaps are pairs of agents which got into each other by more than a pixel
+// (agents pressed together in a jam only touch), per tick; steering time doesn't include counting them.
+struct CrowdRun {
+    double  milliseconds;       // steering per tick
+    double  overlaps;           // per tick
+    float   deepest;            // largest overlap in pixels during the run
+    double  progress;           // share of the way to the goals covered at the end
+};
+
+enum class CrowdSteering { COLLISION_AVOIDANCE, ORCA };
+
+const float OVERLAP_TOLERANCE = 1.0f;
+
+// Pairs overlapping by more than OVERLAP_TOLERANCE, deepest is the largest overlap in pixels
+std::size_t countOverlaps(entt::registry& registry, SpatialHashGrid& grid, float& deepest) {
+    auto crowd = registry.view<Transform, CrowdAgent>();
+
+    grid.clear();
+    crowd.each([&](entt::entity agent, Transform& transform, CrowdAgent& crowdAgent) {
+        grid.insert(agent, transform.position, crowdAgent.radius);
+    });
+    grid.build();
+
+    std::size_t overlaps = 0;
+    crowd.each([&](entt::entity agent, Transform& transform, CrowdAgent& crowdAgent) {
+        grid.queryRadius(transform.position, crowdAgent.radius, [&](const SpatialHashGrid::Item& item) {
+            if(item.entity >= agent) return;    // every pair once
+
+            float overlap = crowdAgent.radius + item.radius - glm::distance(transform.position, item.position);
+            if(overlap > OVERLAP_TOLERANCE) ++overlaps;
+            deepest = std::max(deepest, overlap);
+        });
+    });
+
+    return overlaps;
+}
+
+CrowdRun runCrowd(int agentsCount, int ticksCount, CrowdSteering steering) {
+    const float radius = 8.0f, spacing = 30.0f, delta = 1.0f / 60.0f;
+
+    entt::registry registry;
+    entt::dispatcher dispatcher;
+    srand48(42);
+
+    int columns = int(std::sqrt(float(agentsCount / 2)));
+    int rows = (agentsCount / 2 + columns - 1) / columns;
+    float blockWidth = columns * spacing, gap = 2.0f * spacing;
+    float worldSize = std::max(2.0f * blockWidth + gap, rows * spacing) + 2000.0f;
+    registry.set<GameData>().screenSize = glm::vec2(worldSize, worldSize);
+    registry.set<ThreadPool>(std::size_t(0));
+
+    // The left block goes where the right one starts and the other way round, goals in the same order
+    std::vector<entt::entity> agents;
+    std::vector<glm::vec2> starts, goals;
+    glm::vec2 origin(1000.0f, 1000.0f);     // far from the edges, nobody wraps around
+    for(int i = 0; i < agentsCount; ++i) {
+        int block = i % 2, slot = i / 2;
+        glm::vec2 jitter(drand48() * 2.0f - 1.0f, drand48() * 2.0f - 1.0f);
+        glm::vec2 cell = glm::vec2(slot % columns, slot / columns) * spacing + jitter;
+
+        glm::vec2 left = origin + cell, right = origin + glm::vec2(blockWidth + gap, 0.0f) + cell;
+
+        entt::entity agent = registry.create();
+        registry.assign<Transform>(agent, block == 0 ? left : right, glm::vec2(16.0f, 16.0f), 1.0f, 0.0f);
+        registry.assign<Kinematic>(agent, 100.0f, 400.0f, 180.0f);
+        registry.assign<CrowdAgent>(agent, radius);
+        agents.push_back(agent);
+        starts.push_back(block == 0 ? left : right);
+        goals.push_back(block == 0 ? right : left);
+    }
+
+    NeighbourhoodSystem neighbourhood(60.0f, 10);
+    OrcaSystem<Kinematic> orca;
+    KinematicMovementSystem movement;
+    neighbourhood.enter(registry, dispatcher);
+    orca.enter(registry, dispatcher);
+
+    ThreadPool& pool = registry.ctx<ThreadPool>();
+    std::vector<glm::vec2> velocities(agents.size());
+    SpatialHashGrid grid;
+
+    CrowdRun run{0.0, 0.0, 0.0f, 0.0};
+    for(int tick = 0; tick < ticksCount; ++tick) {
+        auto start = std::chrono::steady_clock::now();
+
+        // Towards the goal at full speed, slowing down in the last second
+        for(std::size_t i = 0; i < agents.size(); ++i) {
+            glm::vec2 toGoal = goals[i] - registry.get<Transform>(agents[i]).position;
+            registry.get<CrowdAgent>(agents[i]).preferredVelocity = wrapVector(toGoal, 100.0f);
+        }
+
+        if(steering == CrowdSteering::ORCA) {
+            orca.update(registry, dispatcher, delta);
+        } else {
+            neighbourhood.update(registry, dispatcher, delta);
+            pool.parallelFor(agents.size(), 256, [&](std::size_t begin, std::size_t end) {
+                for(auto i = begin; i < end; ++i) {
+                    const Kinematic& kinematic = registry.get<Kinematic>(agents[i]);
+                    glm::vec2 matching = (registry.get<CrowdAgent>(agents[i]).preferredVelocity - kinematic.velocity) / 0.1f;
+                    glm::vec2 acceleration = wrapVector(matching, kinematic.maxAcceleration) +
+                                             sb::collisionAvoidance(registry, agents[i], 2.0f * radius).acceleration;
+                    velocities[i] = wrapVector(kinematic.velocity + acceleration * delta, kinematic.maxSpeed);
+                }
+            });
+
+            for(std::size_t i = 0; i < agents.size(); ++i) {
+                registry.get<Kinematic>(agents[i]).velocity = velocities[i];
+            }
+        }
+
+        movement.update(registry, dispatcher, delta);
+
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        run.milliseconds += elapsed.count() / ticksCount;
+        run.overlaps += double(countOverlaps(registry, grid, run.deepest)) / ticksCount;
+    }
+
+    for(std::size_t i = 0; i < agents.size(); ++i) {
+        float left = glm::distance(registry.get<Transform>(agents[i]).position, goals[i]);
+        run.progress += glm::clamp(1.0f - left / glm::distance(starts[i], goals[i]), 0.0f, 1.0f) / agents.size();
+    }
+
+    return run;
+}
+
+void benchmarkCrowd() {
+    printf("Crowd crossing, %u hardware threads\n", std::thread::hardware_concurrency());
+    printf("%8s %6s %-22s %10s %10s %14s %10s %10s\n", "agents", "ticks", "steering", "ms/tick", "ticks/s", "overlaps/tick",
+           "deepest", "progress");
+
+    for(auto size: {std::make_pair(1000, 600), std::make_pair(5000, 300), std::make_pair(20000, 100)}) {
+        for(CrowdSteering steering: {CrowdSteering::COLLISION_AVOIDANCE, CrowdSteering::ORCA}) {
+            CrowdRun run = runCrowd(size.first, size.second, steering);
+            printf("%8d %6d %-22s %10.3f %10.1f %14.1f %8.2fpx %9.0f%%\n", size.first, size.second,
+                   (steering == CrowdSteering::ORCA) ? "ORCA" : "sb::collisionAvoidance", run.milliseconds,
+                   1000.0 / run.milliseconds, run.overlaps, run.deepest, run.progress * 100.0);
+        }
+    }
+}
+
+#endif // CROWDBENCHMARK_H_INCLUDED
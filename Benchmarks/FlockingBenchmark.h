@@ -0,0 +1,122 @@
+#ifndef FLOCKINGBENCHMARK_H_INCLUDED
+#define FLOCKINGBENCHMARK_H_INCLUDED
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <thread>
+
+#include "Benchmark.h"
+#include "Systems/System.h"
+
+// Boids in a wrapping world with about 8 others within the flocking radius of each, whole FlockingSystem +
+// KinematicMovementSystem ticks. Mismatch = boids whose final position differs in any bit from the one thread run.
+// SIMD errors = boids whose first tick acceleration differs from the scalar one by more than 0.5% of
+// maxAcceleration, worst = the largest difference. The lanes sum in a different order and separation's
+// 1 / distance^2 terms of close pairs make it show, up to 0.4% is normal.
+struct FlockingRun {
+    double                  milliseconds;
+    std::vector<glm::vec2>  positions;
+};
+
+std::vector<entt::entity> createFlock(entt::registry& registry, int boidsCount, const FlockingSettings& settings) {
+    srand48(42);
+
+    float worldSize = std::sqrt(float(boidsCount) * settings.radius * settings.radius * 3.14f / 8.0f);
+    registry.set<GameData>().screenSize = glm::vec2(worldSize, worldSize);
+
+    std::vector<entt::entity> boids;
+    for(int i = 0; i < boidsCount; ++i) {
+        entt::entity boid = registry.create();
+        registry.assign<Transform>(boid, glm::vec2(drand48() * worldSize, drand48() * worldSize), glm::vec2(32.0f, 32.0f), 1.0f, 0.0f);
+        registry.assign<Kinematic>(boid, 100.0f, 200.0f, 180.0f).velocity = glm::vec2(drand48() * 200.0f - 100.0f,
+                                                                                      drand48() * 200.0f - 100.0f);
+        registry.assign<Boid>(boid);
+        boids.push_back(boid);
+    }
+
+    return boids;
+}
+
+// Accelerations of the SIMD path which aren't within the tolerance of the scalar ones, NaN included
+int countSimdErrors(int boidsCount, float& worst) {
+    entt::registry registry;
+    FlockingSettings settings;
+    createFlock(registry, boidsCount, settings);
+    ThreadPool pool(1);
+
+    FlockGrid grid;
+    grid.build(registry, settings.radius);
+    grid.computeAccelerations(settings, pool, false);
+    std::vector<glm::vec2> scalar = grid.getAccelerations();
+    grid.computeAccelerations(settings, pool, true);
+    const std::vector<glm::vec2>& vectorised = grid.getAccelerations();
+
+    int errors = 0;
+    worst = 0.0f;
+    for(auto i = 0u; i < scalar.size(); ++i) {
+        float difference = glm::distance(scalar[i], vectorised[i]);
+        if(!(difference <= 5e-3f * registry.get<Kinematic>(grid.getEntities()[i]).maxAcceleration)) errors++;
+        worst = std::max(worst, difference);
+    }
+
+    return errors;
+}
+
+FlockingRun runFlocking(int boidsCount, int ticksCount, std::size_t threadsCount, bool vectorised) {
+    entt::registry registry;
+    entt::dispatcher dispatcher;
+
+    FlockingSettings settings;
+    std::vector<entt::entity> boids = createFlock(registry, boidsCount, settings);
+    registry.set<ThreadPool>(threadsCount);
+
+    FlockingSystem flocking(settings);
+    KinematicMovementSystem movement;
+    flocking.setVectorised(vectorised);
+    flocking.enter(registry, dispatcher);
+
+    FlockingRun run;
+    run.milliseconds = measureMilliseconds([&]() {
+        for(int tick = 0; tick < ticksCount; ++tick) {
+            flocking.update(registry, dispatcher, 1.0f / 60.0f);
+            movement.update(registry, dispatcher, 1.0f / 60.0f);
+        }
+    }, 1);
+
+    for(auto boid: boids) {
+        run.positions.push_back(registry.get<Transform>(boid).position);
+    }
+
+    return run;
+}
+
+void benchmarkFlocking() {
+    const int ticksCount = 20;
+
+    printf("Flocking, %d ticks, %u hardware threads\n", ticksCount, std::thread::hardware_concurrency());
+    printf("%10s %10s %12s %12s %12s %10s %10s %12s %10s\n", "boids", "threads", "scalar(ms)", "SIMD(ms)", "ticks/s", "speedup",
+           "mismatch", "SIMD errors", "worst");
+
+    for(int boidsCount: {1000, 10000, 50000}) {
+        FlockingRun scalar = runFlocking(boidsCount, ticksCount, 1, false);
+        FlockingRun serial = runFlocking(boidsCount, ticksCount, 1, true);
+        float worst;
+        int simdErrors = countSimdErrors(boidsCount, worst);
+
+        for(std::size_t threadsCount: {1, 4}) {
+            FlockingRun run = (threadsCount == 1) ? serial : runFlocking(boidsCount, ticksCount, threadsCount, true);
+
+            int mismatch = 0;
+            for(auto i = 0u; i < run.positions.size(); ++i) {
+                if(std::memcmp(&run.positions[i], &serial.positions[i], sizeof(glm::vec2)) != 0) mismatch++;
+            }
+
+            printf("%10d %10zu %12.3f %12.3f %12.1f %9.2fx %10d %12d %10.4f\n", boidsCount, threadsCount, scalar.milliseconds,
+                   run.milliseconds, ticksCount * 1000.0 / run.milliseconds, scalar.milliseconds / run.milliseconds,
+                   mismatch, simdErrors, worst);
+        }
+    }
+}
+
+#endif // FLOCKINGBENCHMARK_H_INCLUDED
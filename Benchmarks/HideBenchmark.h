@@ -0,0 +1,37 @@
+#ifndef HIDEBENCHMARK_H_INCLUDED
+#define HIDEBENCHMARK_H_INCLUDED
+
+#include <cstdio>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Systems/System.h"
+
+// Brute force view walk vs outward ObstacleGrid search for SteeringManager::hide.
+// Obstacles density is constant (one per 100x100 pixels), one threat in the middle of the world.
+void benchmarkHide() {
+    const int hidersCount = 256;
+
+    printf("hide, %d hiders\n", hidersCount);
+    printBruteVsGridHeader("obstacles", "brute(ms)");
+
+    for(int obstaclesCount: {1000, 10000, 100000}) {
+        entt::registry registry;
+        srand48(42);
+
+        float worldSize = constantDensityWorldSize(obstaclesCount, 100.0f);
+        createObstacles(registry, obstaclesCount, worldSize);
+        entt::entity threat = createAgent(registry, glm::vec2(worldSize * 0.5f, worldSize * 0.5f));
+
+        std::vector<SteeringManager> managers;
+        for(int i = 0; i < hidersCount; ++i) {
+            managers.emplace_back(&registry, createAgent(registry, randomPosition(worldSize)));
+        }
+
+        ObstacleGridSystem gridSystem;
+        auto hide = [&](int i) { return managers[i].hide(threat); };
+        printBruteVsGrid(obstaclesCount, compareBruteWithGrid(hidersCount, hide, registry, gridSystem, hide));
+    }
+}
+
+#endif // HIDEBENCHMARK_H_INCLUDED
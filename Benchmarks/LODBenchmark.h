@@ -0,0 +1,44 @@
+#ifndef LODBENCHMARK_H_INCLUDED
+#define LODBENCHMARK_H_INCLUDED
+
+#include <cstdio>
+
+#include "ScenarioBenchmark.h"
+
+// Generated world without LOD, with levels only and with levels under a compute budget. Agents, updated and
+// deferred are per tick and level (0 nearest the middle of the world), the budget doesn't limit level 0.
+void benchmarkLOD() {
+    const std::size_t agentsCount = 100000;
+    const int ticksCount = 10;
+
+    ScenarioConfig config;
+    config.agentsCount = agentsCount;
+
+    std::vector<const char*> systemNames;
+    ScenarioRun full = runScenario(config, ticksCount, systemNames);
+    double fullMilliseconds = full.systemMilliseconds.back();
+
+    printf("AISteeringSystem level of detail, %zu agents, %d ticks\n", agentsCount, ticksCount);
+    printf("without LOD: %.3f ms per tick\n", fullMilliseconds);
+    printf("%12s %16s %9s %5s %9s %9s %9s\n", "budget(us)", "AISteering(ms)", "speedup", "level", "agents", "updated", "deferred");
+
+    for(double budget: {0.0, 20000.0, 5000.0}) {
+        SteeringLODSettings lod;
+        lod.budgetMicroseconds = budget;
+        ScenarioRun run = runScenario(config, ticksCount, systemNames, &lod);
+
+        double milliseconds = run.systemMilliseconds.back();
+        for(int level = 0; level < SteeringLODSettings::LEVELS_COUNT; ++level) {
+            if(level == 0) {
+                printf("%12.0f %16.3f %8.2fx", budget, milliseconds, fullMilliseconds / milliseconds);
+            } else {
+                printf("%12s %16s %9s", "", "", "");
+            }
+
+            printf(" %5d %9zu %9zu %9zu\n", level, run.lodStats.agents[level] / ticksCount,
+                   run.lodStats.updated[level] / ticksCount, run.lodStats.deferred[level] / ticksCount);
+        }
+    }
+}
+
+#endif // LODBENCHMARK_H_INCLUDED
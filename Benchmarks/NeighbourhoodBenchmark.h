@@ -0,0 +1,47 @@
+#ifndef NEIGHBOURHOODBENCHMARK_H_INCLUDED
+#define NEIGHBOURHOODBENCHMARK_H_INCLUDED
+
+#include <cstdio>
+#include <vector>
+
+#include "Benchmark.h"
+#include "BehaviourManager.h"
+#include "Systems/System.h"
+
+// sb::separation over "all agents" candidate list vs Neighbourhood lists.
+// Constant density: one agent per 50x50 pixels, separation threshold = neighbourhood radius.
+void benchmarkNeighbourhood() {
+    const float threshold = 100.0f;
+
+    printf("sb::separation, threshold %.0f\n", threshold);
+    printBruteVsGridHeader("agents", "all(ms)");
+
+    for(int agentsCount: {1000, 4000, 16000}) {
+        entt::registry registry;
+        srand48(42);
+
+        float worldSize = constantDensityWorldSize(agentsCount, 50.0f);
+        std::vector<entt::entity> agents;
+        for(int i = 0; i < agentsCount; ++i) {
+            entt::entity agent = registry.create();
+            registry.assign<Transform>(agent, randomPosition(worldSize), glm::vec2(32.0f, 32.0f), 1.0f, 0.0f);
+            Kinematic& kinematic = registry.assign<Kinematic>(agent, 100.0f, 200.0f, 180.0f);
+            kinematic.velocity = orientationToVec(drand48() * 2.0f * M_PI) * 50.0f;
+
+            agents.push_back(agent);
+        }
+
+        // Every agent but the owner, in order: agents[i] takes the place of agents[i + 1] for the next owner
+        std::vector<entt::entity> others(agents.begin() + 1, agents.end());
+        auto all = [&](int i) {
+            if(i > 0) others[i - 1] = agents[i - 1];
+            return sb::separation(registry, agents[i], 5000.0f, threshold, others).acceleration;
+        };
+
+        NeighbourhoodSystem neighbourhoodSystem(threshold);
+        auto neighbours = [&](int i) { return sb::separation(registry, agents[i], 5000.0f, threshold).acceleration; };
+        printBruteVsGrid(agentsCount, compareBruteWithGrid(agentsCount, all, registry, neighbourhoodSystem, neighbours, 1));
+    }
+}
+
+#endif // NEIGHBOURHOODBENCHMARK_H_INCLUDED
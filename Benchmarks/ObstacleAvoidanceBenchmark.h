@@ -0,0 +1,39 @@
+#ifndef OBSTACLEAVOIDANCEBENCHMARK_H_INCLUDED
+#define OBSTACLEAVOIDANCEBENCHMARK_H_INCLUDED
+
+#include <cstdio>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Systems/System.h"
+
+// Brute force view walk vs ObstacleGrid for SteeringManager::obstacleAvoiding2.
+// Obstacles density is constant (one per 100x100 pixels), so the world grows with obstacles count.
+void benchmarkObstacleAvoidance() {
+    const int agentsCount = 256;
+
+    printf("obstacleAvoiding2, %d agents\n", agentsCount);
+    printBruteVsGridHeader("obstacles", "brute(ms)");
+
+    for(int obstaclesCount: {1000, 10000, 100000}) {
+        entt::registry registry;
+        srand48(42);
+
+        float worldSize = constantDensityWorldSize(obstaclesCount, 100.0f);
+        createObstacles(registry, obstaclesCount, worldSize);
+
+        std::vector<SteeringManager> managers;
+        for(int i = 0; i < agentsCount; ++i) {
+            entt::entity agent = createAgent(registry, randomPosition(worldSize));
+            registry.get<Physics>(agent).velocity = orientationToVec(drand48() * 2.0f * M_PI) * 100.0f;
+
+            managers.emplace_back(&registry, agent);
+        }
+
+        ObstacleGridSystem gridSystem;
+        auto avoid = [&](int i) { return managers[i].obstacleAvoiding2(); };
+        printBruteVsGrid(obstaclesCount, compareBruteWithGrid(agentsCount, avoid, registry, gridSystem, avoid));
+    }
+}
+
+#endif // OBSTACLEAVOIDANCEBENCHMARK_H_INCLUDED
@@ -0,0 +1,187 @@
+#ifndef PATHBENCHMARK_H_INCLUDED
+#define PATHBENCHMARK_H_INCLUDED
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+#include "Benchmark.h"
+#include "../Path.h"
+
+std::vector<Segment> generatePatrolRoute(int segmentsCount) {
+    std::vector<Segment> segments;
+    glm::vec2 position = glm::vec2(0.0f, 0.0f);
+    for(int i = 0; i < segmentsCount; ++i) {
+        glm::vec2 next = position + glm::vec2(drand48() * 60.0f + 20.0f, drand48() * 80.0f - 40.0f);
+        segments.push_back(Segment{position, next});
+        position = next;
+    }
+
+    return segments;
+}
+
+// Followers walking along the route with a small sideways noise: global getParam vs PathCursor.
+// Off columns count queries which landed further than 10px (in param) from where the follower really is.
+void benchmarkPathCursor() {
+    const int followersCount = 256;
+    const int ticksCount = 64;
+
+    printf("SegmentedPath followers, %d followers x %d ticks\n", followersCount, ticksCount);
+    printf("%10s %12s %12s %10s %12s %12s\n", "segments", "global(ms)", "cursor(ms)", "speedup", "global off", "cursor off");
+
+    for(int segmentsCount: {100, 1000, 10000}) {
+        srand48(42);
+
+        SegmentedPath path;
+        path.setPath(generatePatrolRoute(segmentsCount));
+
+        std::vector<std::vector<glm::vec2>> positions(ticksCount);
+        std::vector<float> trueParams;
+        std::vector<float> params(followersCount);
+        for(auto& param: params) param = drand48() * path.getPathLength() * 0.9f;
+
+        for(int tick = 0; tick < ticksCount; ++tick) {
+            for(int i = 0; i < followersCount; ++i) {
+                params[i] += 3.0f;
+                trueParams.push_back(params[i]);
+                positions[tick].push_back(path.getPosition(params[i]) + glm::vec2(drand48() * 4.0f - 2.0f, drand48() * 4.0f - 2.0f));
+            }
+        }
+
+        std::vector<float> globalParams(followersCount * ticksCount), cursorParams(followersCount * ticksCount);
+
+        double globalTime = measureMilliseconds([&]() {
+            for(int tick = 0; tick < ticksCount; ++tick)
+                for(int i = 0; i < followersCount; ++i)
+                    globalParams[tick * followersCount + i] = path.getParam(positions[tick][i]);
+        }, 1);
+
+        std::vector<PathCursor> cursors(followersCount);
+        double cursorTime = measureMilliseconds([&]() {
+            for(int tick = 0; tick < ticksCount; ++tick)
+                for(int i = 0; i < followersCount; ++i)
+                    cursorParams[tick * followersCount + i] = path.getParam(positions[tick][i], cursors[i]);
+        }, 1);
+
+        int globalOff = 0, cursorOff = 0;
+        for(auto i = 0u; i < trueParams.size(); ++i) {
+            if(std::fabs(globalParams[i] - trueParams[i]) > 10.0f) globalOff++;
+            if(std::fabs(cursorParams[i] - trueParams[i]) > 10.0f) cursorOff++;
+        }
+
+        printf("%10d %12.3f %12.3f %9.1fx %12d %12d\n", segmentsCount, globalTime, cursorTime, globalTime / cursorTime,
+               globalOff, cursorOff);
+    }
+}
+
+// Jittered lattice of streets, each street is one segment. Order of segments doesn't follow the streets,
+// as in a road network exported edge by edge.
+std::vector<Segment> generateRoadNetwork(int segmentsCount) {
+    const float blockSize = 100.0f;
+    int side = int(std::sqrt(segmentsCount / 2.0f)) + 1;
+
+    auto crossing = [&](int x, int y) {
+        srand48(x * 7919 + y);
+        return glm::vec2(x * blockSize + drand48() * 40.0f - 20.0f, y * blockSize + drand48() * 40.0f - 20.0f);
+    };
+
+    std::vector<Segment> segments;
+    for(int y = 0; y < side && int(segments.size()) < segmentsCount; ++y) {
+        for(int x = 0; x < side && int(segments.size()) < segmentsCount; ++x) {
+            segments.push_back(Segment{crossing(x, y), crossing(x + 1, y)});
+            if(int(segments.size()) < segmentsCount) segments.push_back(Segment{crossing(x, y), crossing(x, y + 1)});
+        }
+    }
+
+    return segments;
+}
+
+// Road networks: linear scan vs grid index in getParam. Mismatch counts queries with a different result.
+void benchmarkPathIndex() {
+    const int queriesCount = 4096;
+
+    printf("SegmentedPath road network, %d queries\n", queriesCount);
+    printf("%10s %12s %12s %10s %10s\n", "segments", "linear(ms)", "index(ms)", "speedup", "mismatch");
+
+    for(int segmentsCount: {1000, 10000, 100000}) {
+        std::vector<Segment> segments = generateRoadNetwork(segmentsCount);
+
+        SegmentedPath linearPath, indexedPath;
+        linearPath.setIndexThreshold(segments.size() + 1);
+        linearPath.setPath(segments);
+        indexedPath.setPath(segments);
+
+        srand48(42);
+        std::vector<glm::vec2> positions;
+        for(int i = 0; i < queriesCount; ++i) {
+            const Segment& segment = segments[lrand48() % segments.size()];
+            positions.push_back(segment.start + glm::vec2(drand48() * 200.0f - 100.0f, drand48() * 200.0f - 100.0f));
+        }
+
+        // A few queries far outside of the network
+        for(int i = 0; i < 16; ++i) {
+            positions[i] = glm::vec2(drand48() * 1e5f - 5e4f, -1e4f);
+        }
+
+        std::vector<float> linearParams(queriesCount), indexedParams(queriesCount);
+        double linearTime = measureMilliseconds([&]() {
+            for(int i = 0; i < queriesCount; ++i) linearParams[i] = linearPath.getParam(positions[i]);
+        }, 1);
+
+        double indexTime = measureMilliseconds([&]() {
+            for(int i = 0; i < queriesCount; ++i) indexedParams[i] = indexedPath.getParam(positions[i]);
+        });
+
+        int mismatch = 0;
+        for(int i = 0; i < queriesCount; ++i) {
+            if(linearParams[i] != indexedParams[i]) mismatch++;
+        }
+
+        printf("%10d %12.3f %12.3f %9.1fx %10d\n", segmentsCount, linearTime, indexTime, linearTime / indexTime, mismatch);
+    }
+}
+
+// Random walk patrol routes, SegmentedPath queries from random positions around the route
+void benchmarkPath() {
+    const int queriesCount = 4096;
+
+    printf("SegmentedPath, %d queries\n", queriesCount);
+    printf("%10s %14s %16s\n", "segments", "getParam(ms)", "getPosition(ms)");
+
+    for(int segmentsCount: {100, 1000, 10000}) {
+        srand48(42);
+
+        std::vector<Segment> segments = generatePatrolRoute(segmentsCount);
+
+        SegmentedPath path;
+        path.setPath(segments);
+
+        std::vector<glm::vec2> positions;
+        std::vector<float> params;
+        for(int i = 0; i < queriesCount; ++i) {
+            const Segment& segment = segments[lrand48() % segmentsCount];
+            positions.push_back(segment.start + glm::vec2(drand48() * 60.0f - 30.0f, drand48() * 60.0f - 30.0f));
+            params.push_back(drand48() * path.getPathLength());
+        }
+
+        float checksum = 0.0f;
+        double paramTime = measureMilliseconds([&]() {
+            for(auto position: positions) checksum += path.getParam(position);
+        });
+
+        double positionTime = measureMilliseconds([&]() {
+            for(auto param: params) checksum += path.getPosition(param).x;
+        });
+
+        // Keeps the queries from being optimized away
+        volatile float sink = checksum;
+        (void)sink;
+
+        printf("%10d %14.3f %16.3f\n", segmentsCount, paramTime, positionTime);
+    }
+
+    benchmarkPathCursor();
+    benchmarkPathIndex();
+}
+
+#endif // PATHBENCHMARK_H_INCLUDED
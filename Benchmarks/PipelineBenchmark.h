@@ -0,0 +1,51 @@
+#ifndef PIPELINEBENCHMARK_H_INCLUDED
+#define PIPELINEBENCHMARK_H_INCLUDED
+
+#include <cstdio>
+
+#include "SteeringSystemBenchmark.h"
+
+// Kernel stages only, so AISteeringSystem computes it over an AgentBatch
+using ChasePipeline = sp::Prioritised<sp::Weighted<sp::Pursuit, std::ratio<1, 2>>, sp::Arrive<SteeringManager::FAST>>;
+
+// Pipeline without its batch version, evaluated agent by agent
+template<typename Pipeline>
+struct PerAgent {
+    static glm::vec2 evaluate(SteeringContext& context) { return Pipeline::evaluate(context); }
+};
+
+// The same world steered by SteeringManagers and by DefaultPipeline, then ChasePipeline per agent and batched,
+// single thread. Mismatch = agents whose final position or velocity differ in any bit. Memory is what an agent
+// carries for steering.
+void benchmarkPipelines() {
+    const int ticksCount = 10;
+
+    // SteeringManager itself lives on the stack while the agent is computed
+    std::size_t managerBytes = sizeof(AI);
+
+    printf("SteeringManager vs DefaultPipeline, %d ticks, 1 thread\n", ticksCount);
+    printf("per agent: AI %zu bytes (+ WanderState, WaypointsPath if used), SteeringArchetype %zu bytes\n",
+           managerBytes, sizeof(SteeringArchetype));
+    printf("%10s %14s %14s %10s %10s\n", "agents", "managers(ms)", "pipeline(ms)", "speedup", "mismatch");
+
+    for(int agentsCount: {10000, 50000}) {
+        SteeringSystemRun managers = runSteeringSystem(agentsCount, ticksCount, 1);
+        SteeringSystemRun pipelines = runSteeringSystem(agentsCount, ticksCount, 1, true);
+
+        printf("%10d %14.3f %14.3f %9.2fx %10d\n", agentsCount, managers.milliseconds, pipelines.milliseconds,
+               managers.milliseconds / pipelines.milliseconds, countMismatches(pipelines, managers));
+    }
+
+    printf("\nChasePipeline per agent vs batch kernels, %d ticks, 1 thread\n", ticksCount);
+    printf("%10s %14s %14s %10s %10s\n", "agents", "per agent(ms)", "batch(ms)", "speedup", "mismatch");
+
+    for(int agentsCount: {10000, 50000}) {
+        SteeringSystemRun perAgent = runSteeringSystem<PerAgent<ChasePipeline>>(agentsCount, ticksCount, 1, true);
+        SteeringSystemRun batch = runSteeringSystem<ChasePipeline>(agentsCount, ticksCount, 1, true);
+
+        printf("%10d %14.3f %14.3f %9.2fx %10d\n", agentsCount, perAgent.milliseconds, batch.milliseconds,
+               perAgent.milliseconds / batch.milliseconds, countMismatches(batch, perAgent));
+    }
+}
+
+#endif // PIPELINEBENCHMARK_H_INCLUDED
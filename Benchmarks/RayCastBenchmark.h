@@ -0,0 +1,79 @@
+#ifndef RAYCASTBENCHMARK_H_INCLUDED
+#define RAYCASTBENCHMARK_H_INCLUDED
+
+#include <cstdio>
+#include <vector>
+
+#include "Benchmark.h"
+#include "SegmentBatch.h"
+#include "SteeringManager.h"
+
+// One ray against N segments: per-pair testLineIntersection2D vs batched kernels
+void benchmarkRayCast() {
+    const int raysCount = 1024;
+
+    printf("ray vs segments, %d rays, SIMD width %d\n", raysCount, SEGMENT_BATCH_WIDTH);
+    printf("%10s %12s %12s %12s %10s %10s\n", "segments", "pairs(ms)", "scalar(ms)", "simd(ms)", "speedup", "mismatch");
+
+    for(int segmentsCount: {16, 256, 4096}) {
+        srand48(42);
+
+        std::vector<Line2D> lines;
+        SegmentBatch batch;
+        for(int i = 0; i < segmentsCount; ++i) {
+            glm::vec2 start = glm::vec2(drand48() * 1000.0f, drand48() * 1000.0f);
+            Line2D line{start, start + orientationToVec(drand48() * 2.0f * M_PI) * float(drand48() * 200.0f + 20.0f)};
+
+            lines.push_back(line);
+            batch.push_back(line, glm::normalize(calculatePerp(line.end - line.start)));
+        }
+
+        std::vector<Line2D> rays;
+        for(int i = 0; i < raysCount; ++i) {
+            glm::vec2 start = glm::vec2(drand48() * 1000.0f, drand48() * 1000.0f);
+            rays.push_back(Line2D{start, start + orientationToVec(drand48() * 2.0f * M_PI) * 150.0f});
+        }
+
+        std::vector<float> pairDistances(raysCount), scalarDistances(raysCount), simdDistances(raysCount);
+
+        double pairsTime = measureMilliseconds([&]() {
+            for(int r = 0; r < raysCount; ++r) {
+                float closest = -1.0f;
+                for(const auto& line: lines) {
+                    IntersectionResult result;
+                    if(testLineIntersection2D(line, rays[r], result) &&
+                       result.t1 >= 0.0f && result.t1 <= 1.0f &&
+                       result.t2 >= 0.0f && result.t2 <= 1.0f) {
+                        float distance = glm::distance(rays[r].start, result.point);
+                        if(closest < 0.0f || distance < closest) closest = distance;
+                    }
+                }
+                pairDistances[r] = closest;
+            }
+        });
+
+        auto castAll = [&](bool simd, std::vector<float>& distances) {
+            for(int r = 0; r < raysCount; ++r) {
+                SegmentHit hit;
+                bool found = simd ? rayCastSegments(batch, 0, batch.size(), rays[r], hit) :
+                                    rayCastSegmentsScalar(batch, 0, batch.size(), rays[r], hit);
+                distances[r] = found ? hit.distance : -1.0f;
+            }
+        };
+
+        double scalarTime = measureMilliseconds([&]() { castAll(false, scalarDistances); });
+        double simdTime = measureMilliseconds([&]() { castAll(true, simdDistances); });
+
+        // SIMD must match the scalar kernel bit for bit, the old per-pair path only approximately
+        int mismatches = 0;
+        for(int r = 0; r < raysCount; ++r) {
+            if(scalarDistances[r] != simdDistances[r] ||
+               std::fabs(scalarDistances[r] - pairDistances[r]) > 1e-2f) mismatches++;
+        }
+
+        printf("%10d %12.3f %12.3f %12.3f %9.1fx %10d\n", segmentsCount, pairsTime, scalarTime, simdTime,
+               pairsTime / simdTime, mismatches);
+    }
+}
+
+#endif // RAYCASTBENCHMARK_H_INCLUDED
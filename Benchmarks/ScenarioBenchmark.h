@@ -0,0 +1,197 @@
+#ifndef SCENARIOBENCHMARK_H_INCLUDED
+#define SCENARIOBENCHMARK_H_INCLUDED
+
+#include <cstdio>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <malloc.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "Benchmark.h"
+#include "SystemsManager.h"
+#include "ScenarioGenerator.h"
+
+// Bytes malloc() has handed out and not taken back yet, mmap()ed blocks included. Unlike the resident set it
+// doesn't depend on what earlier runs left in the heap's free lists.
+std::size_t getHeapBytes() {
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+std::size_t getPeakResidentBytes() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return std::size_t(usage.ru_maxrss) * 1024;     // kilobytes on Linux
+}
+
+// Last level cache misses of this thread from perf_event_open. Virtual machines and perf_event_paranoid
+// often don't allow it, then isAvailable() is false and read() returns 0.
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.size = sizeof(attributes);
+        attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+
+        m_descriptor = int(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+    }
+
+    ~CacheMissCounter() {
+        if(isAvailable()) close(m_descriptor);
+    }
+
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    bool isAvailable() const { return m_descriptor >= 0; }
+
+    void start() {
+        if(!isAvailable()) return;
+        ioctl(m_descriptor, PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_descriptor, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    std::uint64_t stop() {
+        if(!isAvailable()) return 0;
+        ioctl(m_descriptor, PERF_EVENT_IOC_DISABLE, 0);
+
+        std::uint64_t count = 0;
+        return (::read(m_descriptor, &count, sizeof(count)) == sizeof(count)) ? count : 0;
+    }
+
+private:
+    int m_descriptor;
+};
+
+struct ScenarioRun {
+    ScenarioStats           stats;
+    double                  ticksPerSecond;
+    std::vector<double>     systemMilliseconds;     // mean per tick, in the order systems were added
+    std::size_t             heapBytes;              // live heap growth caused by the scenario, after the first tick
+    double                  cacheMisses;            // per tick on the main thread, negative without a counter
+    SteeringLODStats        lodStats;               // sum over the timed ticks
+};
+
+// lod is put into the context with its focus in the middle of the world, nullptr runs without LOD
+ScenarioRun runScenario(const ScenarioConfig& config, int ticksCount, std::vector<const char*>& systemNames,
+                        const SteeringLODSettings* lod = nullptr) {
+    std::size_t heapBefore = getHeapBytes();
+
+    ScenarioRun run;
+    SystemsManager manager;
+    entt::registry& registry = manager.getRegistry();
+
+    run.stats = ScenarioGenerator(config).generate(registry);
+    registry.set<GameData>().screenSize = glm::vec2(run.stats.worldSize, run.stats.worldSize);
+    if(lod != nullptr) {
+        registry.set<SteeringLODSettings>(*lod).focus = glm::vec2(run.stats.worldSize, run.stats.worldSize) * 0.5f;
+    }
+
+    // AISteeringSystem is the last one
+    std::vector<shared_ptr<ISystem>> systems = {
+        std::make_shared<PhysicsSystem>(),
+        std::make_shared<ObstacleGridSystem>(),
+        std::make_shared<WallBVHSystem>(),
+        std::make_shared<LocalFrameSystem>(),
+        std::make_shared<AISteeringSystem>()
+    };
+
+    systemNames.clear();
+    for(auto& system: systems) {
+        manager.addSystem(system);
+        systemNames.push_back(system->getName());
+    }
+
+    // The first tick builds the acceleration structures, it's not timed
+    manager.simulate(1.0f / 60.0f);
+    std::size_t heapAfter = getHeapBytes();
+    run.heapBytes = heapAfter - std::min(heapBefore, heapAfter);
+
+    run.systemMilliseconds.assign(systems.size(), 0.0);
+    CacheMissCounter cacheMisses;
+    cacheMisses.start();
+    auto start = std::chrono::steady_clock::now();
+    for(int tick = 0; tick < ticksCount; ++tick) {
+        manager.simulate(1.0f / 60.0f);
+
+        const auto& schedule = manager.getLastSchedule();
+        for(auto i = 0u; i < schedule.size(); ++i) {
+            run.systemMilliseconds[i] += (schedule[i].end - schedule[i].start) / ticksCount;
+        }
+
+        const SteeringLODStats& lodStats = registry.ctx<SteeringLODStats>();
+        for(int level = 0; level < SteeringLODSettings::LEVELS_COUNT; ++level) {
+            run.lodStats.agents[level] += lodStats.agents[level];
+            run.lodStats.updated[level] += lodStats.updated[level];
+            run.lodStats.deferred[level] += lodStats.deferred[level];
+        }
+        run.lodStats.computeMicroseconds += lodStats.computeMicroseconds;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    run.ticksPerSecond = ticksCount / elapsed.count();
+    run.cacheMisses = cacheMisses.isAvailable() ? double(cacheMisses.stop()) / ticksCount : -1.0;
+
+    return run;
+}
+
+// Generated worlds from 100 to 100k agents with the simulation systems of TestScene. Memory is the growth of
+// the live heap, so it includes obstacles, walls and the systems' structures, not only the agents.
+// Cache misses are per agent and tick, counted on the main thread only.
+void benchmarkScenario() {
+    printf("Generated scenarios, seed 1, %u hardware threads\n", std::max(1u, std::thread::hardware_concurrency()));
+
+    std::vector<const char*> systemNames;
+    bool header = true;
+
+    for(std::size_t agentsCount: {100, 1000, 10000, 100000}) {
+        ScenarioConfig config;
+        config.agentsCount = agentsCount;
+
+        int ticksCount = int(std::max<std::size_t>(5, 200000 / agentsCount));
+        ScenarioRun run = runScenario(config, ticksCount, systemNames);
+
+        if(header) {
+            printf("%8s %9s %7s %8s %10s", "agents", "obstacles", "walls", "ticks", "ticks/s");
+            for(auto name: systemNames) printf(" %14.14s", name);
+            printf(" %10s %10s %11s %12s\n", "heap(MB)", "peak(MB)", "bytes/agent", "misses/agent");
+            header = false;
+        }
+
+        printf("%8zu %9zu %7zu %8d %10.1f", agentsCount, run.stats.obstacles, run.stats.walls, ticksCount, run.ticksPerSecond);
+        for(auto milliseconds: run.systemMilliseconds) printf(" %11.3f ms", milliseconds);
+        printf(" %10.1f %10.1f %11.0f", run.heapBytes / 1048576.0, getPeakResidentBytes() / 1048576.0,
+               double(run.heapBytes) / agentsCount);
+        if(run.cacheMisses >= 0.0) {
+            printf(" %12.2f\n", run.cacheMisses / agentsCount);
+        } else {
+            printf(" %12s\n", "n/a");
+        }
+    }
+
+    // Same world, every enabled behaviour evaluated vs skipping the low priority ones once the force budget is spent
+    printf("\nCombination modes, 10000 agents\n");
+    printf("%14s %10s %20s\n", "mode", "ticks/s", "AISteeringSystem");
+    for(auto mode: {SteeringSettings::WEIGHTED_SUM, SteeringSettings::PRIORITISED}) {
+        ScenarioConfig config;
+        config.agentsCount = 10000;
+        config.combination = mode;
+
+        ScenarioRun run = runScenario(config, 20, systemNames);
+        printf("%14s %10.1f %17.3f ms\n", (mode == SteeringSettings::PRIORITISED) ? "prioritised" : "weighted sum",
+               run.ticksPerSecond, run.systemMilliseconds.back());
+    }
+}
+
+#endif // SCENARIOBENCHMARK_H_INCLUDED
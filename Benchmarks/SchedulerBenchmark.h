@@ -0,0 +1,141 @@
+#ifndef SCHEDULERBENCHMARK_H_INCLUDED
+#define SCHEDULERBENCHMARK_H_INCLUDED
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <iostream>
+
+#include "Benchmark.h"
+#include "SystemsManager.h"
+
+// Stands in for the rendering systems: main thread only, reads what they read
+class MainThreadProbeSystem: public ISystem {
+public:
+    MainThreadProbeSystem(ThreadPool& pool): m_pool(pool), m_wrongThread(0) {
+        iterates<Transform, Physics>();
+        reads<Transform, Physics>();
+        writesResource<SDL_Renderer>();
+        runOnMainThread();
+    }
+
+    virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) {
+        if(m_pool.getCurrentThreadIndex() != 0) m_wrongThread++;
+
+        float sum = 0.0f;
+        registry.view<Transform, Physics>().each([&](entt::entity, Transform& transform, Physics& physics) {
+            sum += transform.position.x + physics.radius;
+        });
+        m_checksum = sum;
+    }
+
+    virtual const char* getName() const { return "MainThreadProbeSystem"; }
+
+    int getWrongThread() const { return m_wrongThread; }
+
+private:
+    ThreadPool& m_pool;
+    int m_wrongThread;
+    volatile float m_checksum;
+};
+
+struct SchedulerRun {
+    double                  milliseconds;
+    int                     wrongThread;
+    std::vector<glm::vec2>  positions;
+};
+
+SchedulerRun runScheduler(int agentsCount, int framesCount, std::size_t threadsCount, bool trace) {
+    SystemsManager manager(threadsCount);
+    entt::registry& registry = manager.getRegistry();
+    srand48(42);
+
+    float worldSize = std::sqrt(float(agentsCount)) * 40.0f;
+    registry.set<GameData>().screenSize = glm::vec2(worldSize, worldSize);
+
+    createObstacles(registry, agentsCount / 8, worldSize);
+
+    for(int i = 0; i < 64; ++i) {
+        glm::vec2 start = glm::vec2(drand48() * worldSize, drand48() * worldSize);
+        registry.assign<Wall>(registry.create(), Line2D{start, start + glm::vec2(drand48() * 200.0f - 100.0f, drand48() * 200.0f - 100.0f)},
+                              SDL_Color{0, 255, 0, 255});
+    }
+
+    entt::entity leader = registry.create();
+    registry.assign<Transform>(leader, glm::vec2(worldSize * 0.5f, worldSize * 0.5f), glm::vec2(32.0f, 32.0f), 1.0f, 0.0f);
+    registry.assign<Physics>(leader, 150.0f, 1.0f, 200.0f, 100.0f, 20.0f).velocity = glm::vec2(100.0f, 30.0f);
+
+    std::vector<entt::entity> agents;
+    for(int i = 0; i < agentsCount; ++i) {
+        entt::entity agent = registry.create();
+        registry.assign<Transform>(agent, glm::vec2(drand48() * worldSize, drand48() * worldSize), glm::vec2(32.0f, 32.0f), 1.0f, 0.0f);
+        registry.assign<Physics>(agent, 150.0f, 1.0f, 200.0f, 100.0f, 20.0f);
+        registry.assign<Kinematic>(agent, 150.0f, 200.0f, 100.0f);
+
+        registry.assign<AI>(agent, (i % 16 == 0) ? leader : agents.back());
+        agents.push_back(agent);
+    }
+
+    auto probe = std::make_shared<MainThreadProbeSystem>(registry.ctx<ThreadPool>());
+    manager.addSystem(probe);
+    manager.addSystem(std::make_shared<PhysicsSystem>());
+    manager.addSystem(std::make_shared<ObstacleGridSystem>());
+    manager.addSystem(std::make_shared<WallBVHSystem>());
+    manager.addSystem(std::make_shared<NeighbourhoodSystem>());
+    manager.addSystem(std::make_shared<LocalFrameSystem>());
+    manager.addSystem(std::make_shared<AISteeringSystem>());
+
+    SchedulerRun run;
+    run.milliseconds = measureMilliseconds([&]() {
+        for(int frame = 0; frame < framesCount; ++frame) {
+            if(trace && frame == framesCount - 1) manager.setScheduleTrace(&std::cout);
+            manager.update(1.0f / 60.0f);
+        }
+    }, 1);
+    manager.setScheduleTrace(nullptr);
+
+#ifdef AI_PROFILE_SYSTEMS
+    if(trace) {
+        printf("%-24s %10s %10s %10s %10s %10s\n", "system", "min(ms)", "mean(ms)", "p99(ms)", "max(ms)", "entities");
+        for(const auto& stats: manager.getSystemStats()) {
+            printf("%-24s %10.3f %10.3f %10.3f %10.3f %10zu\n", stats.name, stats.min, stats.mean, stats.p99, stats.max, stats.entities);
+        }
+    }
+#endif
+
+    run.wrongThread = probe->getWrongThread();
+    for(auto agent: agents) {
+        run.positions.push_back(registry.get<Transform>(agent).position);
+    }
+
+    return run;
+}
+
+// Whole frames of simulation systems through SystemsManager. Mismatch compares final positions with one thread,
+// wrong thread counts main thread systems which ran elsewhere.
+void benchmarkScheduler() {
+    const int agentsCount = 20000;
+    const int framesCount = 10;
+
+    printf("SystemsManager, %d agents, %d frames\n", agentsCount, framesCount);
+    printf("%10s %12s %12s %10s %10s %12s\n", "threads", "total(ms)", "frame(ms)", "speedup", "mismatch", "wrong thread");
+
+    SchedulerRun serial = runScheduler(agentsCount, framesCount, 1, false);
+
+    for(std::size_t threadsCount: {1, 2, 4, 8}) {
+        SchedulerRun run = (threadsCount == 1) ? serial : runScheduler(agentsCount, framesCount, threadsCount, false);
+
+        int mismatch = 0;
+        for(int i = 0; i < agentsCount; ++i) {
+            if(std::memcmp(&run.positions[i], &serial.positions[i], sizeof(glm::vec2)) != 0) mismatch++;
+        }
+
+        printf("%10zu %12.3f %12.3f %9.1fx %10d %12d\n", threadsCount, run.milliseconds, run.milliseconds / framesCount,
+               serial.milliseconds / run.milliseconds, mismatch, run.wrongThread);
+    }
+
+    printf("Schedule of the last frame, 4 threads\n");
+    runScheduler(agentsCount, framesCount, 4, true);
+}
+
+#endif // SCHEDULERBENCHMARK_H_INCLUDED
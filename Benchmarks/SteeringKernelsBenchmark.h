@@ -0,0 +1,87 @@
+#ifndef STEERINGKERNELSBENCHMARK_H_INCLUDED
+#define STEERINGKERNELSBENCHMARK_H_INCLUDED
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <functional>
+
+#include "Benchmark.h"
+#include "SteeringManager.h"
+#include "SteeringKernels.h"
+
+// SteeringManager per agent vs gather + batch kernel over AgentBatch, every agent pursues a random other agent.
+// Mismatch counts forces differing by more than 1e-4 relative (NaN equals NaN: flee from its own position divides by zero).
+void benchmarkSteeringKernels() {
+    const int agentsCount = 100000;
+
+    entt::registry registry;
+    srand48(42);
+
+    std::vector<entt::entity> agents, targets;
+    std::vector<SteeringManager> managers;
+    for(int i = 0; i < agentsCount; ++i) {
+        glm::vec2 velocity = glm::vec2(drand48() * 200.0f - 100.0f, drand48() * 200.0f - 100.0f);
+
+        entt::entity agent = registry.create();
+        registry.assign<Transform>(agent, glm::vec2(drand48() * 20000.0f, drand48() * 20000.0f), glm::vec2(32.0f, 32.0f), 1.0f,
+                                   vecToOrientation(velocity));
+        registry.assign<Physics>(agent, 150.0f, 1.0f, 200.0f, 100.0f, 20.0f).velocity = velocity;
+
+        agents.push_back(agent);
+        managers.emplace_back(&registry, agent);
+    }
+
+    for(int i = 0; i < agentsCount; ++i) {
+        targets.push_back(agents[(i + 1 + lrand48() % (agentsCount - 1)) % agentsCount]);
+    }
+
+    // Half of the agents are close to their target, so flee and evade aren't all zero
+    for(int i = 0; i < agentsCount; i += 2) {
+        registry.get<Transform>(agents[i]).position = registry.get<Transform>(targets[i]).position +
+                                                      glm::vec2(drand48() * 400.0f - 200.0f, drand48() * 400.0f - 200.0f);
+    }
+
+    struct Behaviour {
+        const char*                             name;
+        std::function<glm::vec2(std::size_t)>   scalar;
+        std::function<void(sk::AgentBatch&)>    batch;
+    };
+
+    auto position = [&](std::size_t i) { return registry.get<Transform>(targets[i]).position; };
+    const Behaviour behaviours[] = {
+        {"seek", [&](std::size_t i) { return managers[i].seek(position(i)); }, [](sk::AgentBatch& batch) { sk::seek(batch); }},
+        {"flee", [&](std::size_t i) { return managers[i].flee(position(i)); }, [](sk::AgentBatch& batch) { sk::flee(batch); }},
+        {"arrive", [&](std::size_t i) { return managers[i].arrive(position(i), SteeringManager::MEDIUM); },
+                   [](sk::AgentBatch& batch) { sk::arrive(batch, SteeringManager::MEDIUM); }},
+        {"pursuit", [&](std::size_t i) { return managers[i].pursuit(targets[i]); }, [](sk::AgentBatch& batch) { sk::pursuit(batch); }},
+        {"evade", [&](std::size_t i) { return managers[i].evade(targets[i]); }, [](sk::AgentBatch& batch) { sk::evade(batch); }},
+    };
+
+    sk::AgentBatch batch;
+    double gatherTime = measureMilliseconds([&]() { sk::gather(registry, agents, targets, batch); });
+
+    printf("Steering kernels, %d agents, gather %.3f ms\n", agentsCount, gatherTime);
+    printf("%10s %12s %12s %12s %14s %10s\n", "behaviour", "scalar(ms)", "batch(ms)", "speedup", "with gather", "mismatch");
+
+    std::vector<glm::vec2> forces(agentsCount);
+    for(const Behaviour& behaviour: behaviours) {
+        double scalarTime = measureMilliseconds([&]() {
+            for(int i = 0; i < agentsCount; ++i) forces[i] = behaviour.scalar(i);
+        });
+
+        double batchTime = measureMilliseconds([&]() { behaviour.batch(batch); });
+
+        int mismatches = 0;
+        for(int i = 0; i < agentsCount; ++i) {
+            glm::vec2 force = batch.getForce(i);
+            bool bothNaN = std::isnan(force.x) && std::isnan(forces[i].x);
+            if(!bothNaN && !(glm::distance(force, forces[i]) <= 1e-4f * std::max(1.0f, glm::length(forces[i])))) mismatches++;
+        }
+
+        printf("%10s %12.3f %12.3f %11.1fx %13.1fx %10d\n", behaviour.name, scalarTime, batchTime,
+               scalarTime / batchTime, scalarTime / (batchTime + gatherTime), mismatches);
+    }
+}
+
+#endif // STEERINGKERNELSBENCHMARK_H_INCLUDED
@@ -0,0 +1,110 @@
+#ifndef STEERINGSYSTEMBENCHMARK_H_INCLUDED
+#define STEERINGSYSTEMBENCHMARK_H_INCLUDED
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <thread>
+
+#include "Benchmark.h"
+#include "Systems/System.h"
+
+// Agents chasing a leader through an obstacle field, whole AISteeringSystem ticks.
+// Final positions and velocities are compared with the single thread run (mismatch = agents differing in any bit).
+struct SteeringSystemRun {
+    double                  milliseconds;
+    std::vector<glm::vec2>  positions;
+    std::vector<glm::vec2>  velocities;
+};
+
+// DefaultPipeline computes what a default SteeringManager does, pipelines = true uses Pipeline instead of AI
+using DefaultPipeline = sp::WeightedSum<sp::Weighted<sp::ObstacleAvoidance, std::ratio<7, 10>>,
+                                        sp::Weighted<sp::OffsetPursuit<-48, -48>, std::ratio<3, 10>>>;
+
+template<typename Pipeline = DefaultPipeline>
+SteeringSystemRun runSteeringSystem(int agentsCount, int ticksCount, std::size_t threadsCount, bool pipelines = false) {
+    entt::registry registry;
+    entt::dispatcher dispatcher;
+    srand48(42);
+
+    float worldSize = std::sqrt(float(agentsCount)) * 40.0f;
+    registry.set<GameData>().screenSize = glm::vec2(worldSize, worldSize);
+    registry.set<ThreadPool>(threadsCount);
+
+    createObstacles(registry, agentsCount / 8, worldSize);
+
+    entt::entity leader = registry.create();
+    registry.assign<Transform>(leader, glm::vec2(worldSize * 0.5f, worldSize * 0.5f), glm::vec2(32.0f, 32.0f), 1.0f, 0.0f);
+    registry.assign<Physics>(leader, 150.0f, 1.0f, 200.0f, 100.0f, 20.0f).velocity = glm::vec2(100.0f, 30.0f);
+
+    std::vector<entt::entity> agents;
+    for(int i = 0; i < agentsCount; ++i) {
+        entt::entity agent = registry.create();
+        registry.assign<Transform>(agent, glm::vec2(drand48() * worldSize, drand48() * worldSize), glm::vec2(32.0f, 32.0f), 1.0f, 0.0f);
+        registry.assign<Physics>(agent, 150.0f, 1.0f, 200.0f, 100.0f, 20.0f);
+
+        entt::entity target = (i % 16 == 0) ? leader : agents.back();
+        if(pipelines) {
+            registry.assign<SteeringArchetype>(agent, std::uint16_t(0), target);
+        } else {
+            registry.assign<AI>(agent, target);
+        }
+        agents.push_back(agent);
+    }
+
+    PhysicsSystem physicsSystem;
+    ObstacleGridSystem gridSystem;
+    AISteeringSystem steeringSystem;
+    steeringSystem.addArchetype<Pipeline>(0);
+    gridSystem.enter(registry, dispatcher);
+    steeringSystem.enter(registry, dispatcher);
+
+    SteeringSystemRun run;
+    run.milliseconds = measureMilliseconds([&]() {
+        for(int tick = 0; tick < ticksCount; ++tick) {
+            physicsSystem.update(registry, dispatcher, 1.0f / 60.0f);
+            gridSystem.update(registry, dispatcher, 1.0f / 60.0f);
+            steeringSystem.update(registry, dispatcher, 1.0f / 60.0f);
+        }
+    }, 1);
+
+    for(auto agent: agents) {
+        run.positions.push_back(registry.get<Transform>(agent).position);
+        run.velocities.push_back(registry.get<Physics>(agent).velocity);
+    }
+
+    return run;
+}
+
+int countMismatches(const SteeringSystemRun& run, const SteeringSystemRun& reference) {
+    int mismatch = 0;
+    for(auto i = 0u; i < run.positions.size(); ++i) {
+        if(std::memcmp(&run.positions[i], &reference.positions[i], sizeof(glm::vec2)) != 0 ||
+           std::memcmp(&run.velocities[i], &reference.velocities[i], sizeof(glm::vec2)) != 0) {
+            mismatch++;
+        }
+    }
+
+    return mismatch;
+}
+
+void benchmarkSteeringSystem() {
+    const int ticksCount = 10;
+
+    printf("AISteeringSystem, %d ticks, %u hardware threads\n", ticksCount, std::thread::hardware_concurrency());
+    printf("%10s %10s %12s %12s %10s %10s\n", "agents", "threads", "total(ms)", "ticks/s", "speedup", "mismatch");
+
+    for(int agentsCount: {10000, 50000}) {
+        SteeringSystemRun serial = runSteeringSystem(agentsCount, ticksCount, 1);
+
+        for(std::size_t threadsCount: {1, 2, 4, 8}) {
+            SteeringSystemRun run = (threadsCount == 1) ? serial : runSteeringSystem(agentsCount, ticksCount, threadsCount);
+
+            int mismatch = countMismatches(run, serial);
+            printf("%10d %10zu %12.3f %12.1f %9.1fx %10d\n", agentsCount, threadsCount, run.milliseconds,
+                   ticksCount * 1000.0 / run.milliseconds, serial.milliseconds / run.milliseconds, mismatch);
+        }
+    }
+}
+
+#endif // STEERINGSYSTEMBENCHMARK_H_INCLUDED
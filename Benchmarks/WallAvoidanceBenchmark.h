@@ -0,0 +1,71 @@
+#ifndef WALLAVOIDANCEBENCHMARK_H_INCLUDED
+#define WALLAVOIDANCEBENCHMARK_H_INCLUDED
+
+#include <cstdio>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Systems/System.h"
+
+// Brute force feelers vs WallBVH for SteeringManager::wallAvoidance.
+// Short random walls with constant density (one per 100x100 pixels).
+void benchmarkWallAvoidance() {
+    const int agentsCount = 256;
+
+    printf("wallAvoidance, %d agents\n", agentsCount);
+    printf("%10s %12s %12s %12s %10s %10s\n", "walls", "brute(ms)", "build(ms)", "query(ms)", "speedup", "mismatch");
+
+    for(int wallsCount: {1000, 10000, 100000}) {
+        entt::registry registry;
+        entt::dispatcher dispatcher;
+        srand48(42);
+
+        float worldSize = std::sqrt(float(wallsCount)) * 100.0f;
+        for(int i = 0; i < wallsCount; ++i) {
+            glm::vec2 start = glm::vec2(drand48() * worldSize, drand48() * worldSize);
+            glm::vec2 end = start + orientationToVec(drand48() * 2.0f * M_PI) * float(drand48() * 80.0f + 20.0f);
+
+            entt::entity wall = registry.create();
+            registry.assign<Wall>(wall, Line2D{start, end}, SDL_Color{0, 255, 0, 255});
+        }
+
+        std::vector<SteeringManager> managers;
+        for(int i = 0; i < agentsCount; ++i) {
+            entt::entity agent = registry.create();
+            registry.assign<Transform>(agent, glm::vec2(drand48() * worldSize, drand48() * worldSize), glm::vec2(32.0f, 32.0f), 1.0f, 0.0f);
+            Physics& physics = registry.assign<Physics>(agent, 150.0f, 1.0f, 200.0f, 100.0f, 20.0f);
+            physics.velocity = orientationToVec(drand48() * 2.0f * M_PI) * 100.0f;
+
+            managers.emplace_back(&registry, agent);
+        }
+
+        std::vector<glm::vec2> bruteForces(agentsCount), bvhForces(agentsCount);
+
+        double bruteTime = measureMilliseconds([&]() {
+            for(int i = 0; i < agentsCount; ++i) bruteForces[i] = managers[i].wallAvoidance();
+        });
+
+        WallBVHSystem bvhSystem;
+        bvhSystem.enter(registry, dispatcher);
+
+        double buildTime = measureMilliseconds([&]() {
+            registry.ctx<WallBVH>().rebuild(registry);
+        });
+
+        double queryTime = measureMilliseconds([&]() {
+            for(int i = 0; i < agentsCount; ++i) bvhForces[i] = managers[i].wallAvoidance();
+        });
+
+        int mismatches = 0;
+        for(int i = 0; i < agentsCount; ++i) {
+            if(glm::distance(bruteForces[i], bvhForces[i]) > 1e-3f * std::max(1.0f, glm::length(bruteForces[i]))) mismatches++;
+        }
+
+        printf("%10d %12.3f %12.3f %12.3f %9.1fx %10d\n", wallsCount, bruteTime, buildTime, queryTime,
+               bruteTime / queryTime, mismatches);
+
+        registry.ctx<WallBVH>().disconnect(registry);
+    }
+}
+
+#endif // WALLAVOIDANCEBENCHMARK_H_INCLUDED
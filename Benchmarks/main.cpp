@@ -0,0 +1,117 @@
+#include <cstring>
+#include <cstdlib>
+
+#include "ObstacleAvoidanceBenchmark.h"
+#include "WallAvoidanceBenchmark.h"
+#include "RayCastBenchmark.h"
+#include "NeighbourhoodBenchmark.h"
+#include "HideBenchmark.h"
+#include "PathBenchmark.h"
+#include "SteeringSystemBenchmark.h"
+#include "SchedulerBenchmark.h"
+#include "BehaviourBenchmark.h"
+#include "ScenarioBenchmark.h"
+#include "SteeringKernelsBenchmark.h"
+#include "PipelineBenchmark.h"
+#include "LODBenchmark.h"
+#include "FlockingBenchmark.h"
+#include "CrowdBenchmark.h"
+
+const char* USAGE = "Usage: %s [BENCHMARK...] [--json FILE] [--compare BASELINE] [--threshold PERCENT]\n"
+                    "Benchmarks: obstacles walls raycast neighbourhood hide path system scheduler scenario kernels pipelines lod flocking crowd behaviours\n"
+                    "--json and --compare take the results of the behaviours benchmark. --compare exits with 2\n"
+                    "if any behaviour got slower than the baseline by more than the threshold (10%% by default).\n";
+
+struct BenchmarkEntry {
+    const char* name;
+    void (*run)();
+};
+
+int main(int argc, char* argv[]) {
+    const BenchmarkEntry benchmarks[] = {
+        {"obstacles", benchmarkObstacleAvoidance},
+        {"walls", benchmarkWallAvoidance},
+        {"raycast", benchmarkRayCast},
+        {"neighbourhood", benchmarkNeighbourhood},
+        {"hide", benchmarkHide},
+        {"path", benchmarkPath},
+        {"system", benchmarkSteeringSystem},
+        {"scheduler", benchmarkScheduler},
+        {"scenario", benchmarkScenario},
+        {"kernels", benchmarkSteeringKernels},
+        {"pipelines", benchmarkPipelines},
+        {"lod", benchmarkLOD},
+        {"flocking", benchmarkFlocking},
+        {"crowd", benchmarkCrowd},
+    };
+
+    std::vector<std::string> selected;
+    const char* jsonFile = nullptr;
+    const char* baselineFile = nullptr;
+    double threshold = 10.0;
+
+    for(int i = 1; i < argc; ++i) {
+        if(std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonFile = argv[++i];
+        } else if(std::strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            baselineFile = argv[++i];
+        } else if(std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = std::atof(argv[++i]);
+        } else if(argv[i][0] != '-') {
+            selected.push_back(argv[i]);
+        } else {
+            printf(USAGE, argv[0]);
+            return 1;
+        }
+    }
+
+    for(const auto& name: selected) {
+        bool known = (name == "behaviours");
+        for(const auto& benchmark: benchmarks) {
+            known = known || (name == benchmark.name);
+        }
+
+        if(!known) {
+            printf("Unknown benchmark %s\n", name.c_str());
+            printf(USAGE, argv[0]);
+            return 1;
+        }
+    }
+
+    auto isSelected = [&](const char* name) {
+        return selected.empty() || std::find(selected.begin(), selected.end(), name) != selected.end();
+    };
+
+    if((jsonFile != nullptr || baselineFile != nullptr) && !isSelected("behaviours")) {
+        printf("--json and --compare need the behaviours benchmark\n");
+        printf(USAGE, argv[0]);
+        return 1;
+    }
+
+    for(const auto& benchmark: benchmarks) {
+        if(isSelected(benchmark.name)) benchmark.run();
+    }
+
+    if(!isSelected("behaviours")) return 0;
+
+    std::vector<BenchmarkResult> results = benchmarkBehaviours();
+
+    if(jsonFile != nullptr && !writeResultsJson(results, jsonFile)) {
+        printf("Can't write %s\n", jsonFile);
+        return 1;
+    }
+
+    if(baselineFile != nullptr) {
+        std::vector<BenchmarkResult> baseline;
+        if(!readResultsJson(baselineFile, baseline)) {
+            printf("Can't read %s\n", baselineFile);
+            return 1;
+        }
+
+        int regressions = compareWithBaseline(results, baseline, threshold);
+        printf("%d regressions over %.1f%%\n", regressions, threshold);
+        if(regressions > 0) return 2;
+    }
+
+    return 0;
+}
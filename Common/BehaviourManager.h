@@ -1,8 +1,11 @@
 #ifndef BEHAVIOURMANAGER_H_INCLUDED
 #define BEHAVIOURMANAGER_H_INCLUDED
 
+#include <iostream>
+
 #include "glm/glm.hpp"
 #include "Components/Components.h"
+#include "Neighbourhood.h"
 #include "../Path.h"
 
 
@@ -267,7 +270,14 @@ namespace SteeringBehaviours {
         Kinematic& kinematic = registry.get<Kinematic>(owner);
         const auto& path = registry.get<Path>(epath).path;
 
-        glm::vec2 target = path->getPosition(path->getParam(transform.position) + 80.0f);
+        float param;
+        if(auto cursor = registry.try_get<PathCursor>(owner); cursor) {
+            param = path->getParam(transform.position, *cursor);
+        } else {
+            param = path->getParam(transform.position);
+        }
+
+        glm::vec2 target = path->getPosition(param + 80.0f);
 
         return seek(registry, owner, target);
     }
@@ -284,15 +294,22 @@ namespace SteeringBehaviours {
             velocity = glm::normalize(velocity);
 
         glm::vec2 target = transform.position + velocity * kinematic.maxSpeed * time;
-        target = path->getPosition(path->getParam(target) + 80.0f);
+        float param;
+        if(auto cursor = registry.try_get<PathCursor>(owner); cursor) {
+            param = path->getParam(target, *cursor);
+        } else {
+            param = path->getParam(target);
+        }
+
+        target = path->getPosition(param + 80.0f);
         return seek(registry, owner, target);
     }
 
-    Output separation(entt::registry& registry, entt::entity owner, float k, float threshold, std::vector<entt::entity> targets) {
+    Output separation(entt::registry& registry, entt::entity owner, float k, float threshold, const std::vector<entt::entity>& targets) {
         Transform& transform = registry.get<Transform>(owner);
         Kinematic& kinematic = registry.get<Kinematic>(owner);
 
-        Output output;
+        Output output{glm::vec2(0.0f), 0.0f};
         for(auto target: targets) {
             if(auto targetTransform = registry.try_get<Transform>(target); targetTransform) {
                 glm::vec2 direction = transform.position - targetTransform->position;
@@ -308,7 +325,29 @@ namespace SteeringBehaviours {
         return output;
     }
 
-    Output collisionAvoidance(entt::registry& registry, entt::entity owner, float radius, std::vector<entt::entity> targets) {
+    Output separation(entt::registry& registry, entt::entity owner, float k, float threshold, Span<const Neighbour> neighbours) {
+        Transform& transform = registry.get<Transform>(owner);
+        Kinematic& kinematic = registry.get<Kinematic>(owner);
+
+        Output output{glm::vec2(0.0f), 0.0f};
+        for(const auto& neighbour: neighbours) {
+            if(neighbour.distance < threshold && neighbour.distance > 0.0f) {
+                glm::vec2 direction = transform.position - neighbour.position;
+                float strength = std::min(k / (neighbour.distance * neighbour.distance), kinematic.maxAcceleration);
+
+                output.acceleration += direction / neighbour.distance * strength;
+            }
+        }
+
+        return output;
+    }
+
+    //Targets are taken from the Neighbourhood context, threshold should not exceed its radius
+    Output separation(entt::registry& registry, entt::entity owner, float k, float threshold) {
+        return separation(registry, owner, k, threshold, registry.ctx<Neighbourhood>().get(owner));
+    }
+
+    Output collisionAvoidance(entt::registry& registry, entt::entity owner, float radius, const std::vector<entt::entity>& targets) {
         Transform& transform = registry.get<Transform>(owner);
         Kinematic& kinematic = registry.get<Kinematic>(owner);
 
@@ -327,8 +366,7 @@ namespace SteeringBehaviours {
             glm::vec2 rp = targetTransform.position - transform.position;
             glm::vec2 rv = targetKinematic.velocity - kinematic.velocity;
 
-            float t = glm::dot(rp, rv) / glm::pow(glm::length(rv), 2);
-            std::cout <<t << std::endl;
+            float t = glm::dot(rp, rv) / glm::dot(rv, rv);
 
             if(t > max_time || t < 0.0f) continue;
 
@@ -357,6 +395,50 @@ namespace SteeringBehaviours {
 
         return output;
     }
+
+    Output collisionAvoidance(entt::registry& registry, entt::entity owner, float radius, Span<const Neighbour> neighbours) {
+        Transform& transform = registry.get<Transform>(owner);
+        Kinematic& kinematic = registry.get<Kinematic>(owner);
+
+        const Neighbour* closest = nullptr;
+        float max_time = 5.0f;
+        float shortestTime = max_time;
+
+        for(const auto& neighbour: neighbours) {
+            glm::vec2 rp = neighbour.position - transform.position;
+            glm::vec2 rv = neighbour.velocity - kinematic.velocity;
+
+            float t = glm::dot(rp, rv) / glm::dot(rv, rv);
+
+            if(t > max_time || t < 0.0f) continue;
+
+            if(t < shortestTime) {
+                shortestTime = t;
+                closest = &neighbour;
+            }
+        }
+
+        Output output{};
+        if(closest != nullptr) {
+            glm::vec2 futurePos = transform.position + kinematic.velocity * shortestTime;
+            glm::vec2 targetFuturePos = closest->position + closest->velocity * shortestTime;
+
+            glm::vec2 relativePos = futurePos - targetFuturePos;
+
+            if(glm::length(relativePos) < radius) {
+                output.acceleration = glm::normalize(relativePos) * kinematic.maxAcceleration;
+            }
+        }
+
+        return output;
+    }
+
+    //Targets are taken from the Neighbourhood context. Unlike the list version, agents beyond its radius aren't
+    //seen even if they would collide within the 5 s lookahead: for the same result the radius has to cover
+    //both agents' maxSpeed * 5 s
+    Output collisionAvoidance(entt::registry& registry, entt::entity owner, float radius) {
+        return collisionAvoidance(registry, owner, radius, registry.ctx<Neighbourhood>().get(owner));
+    }
 }
 
 namespace sb = SteeringBehaviours;
@@ -1,6 +1,8 @@
 #ifndef COMMON_H_INCLUDED
 #define COMMON_H_INCLUDED
 
+#include <cstddef>
+#include <vector>
 #include <glm/glm.hpp>
 
 using Point = glm::vec2;
@@ -10,4 +12,30 @@ struct Line2D {
     glm::vec2 end;
 };
 
+// Non-owning view of contiguous elements (we don't have std::span in C++17)
+template<typename T>
+class Span {
+public:
+    Span(): m_data(nullptr), m_size(0) { }
+    Span(T* data, std::size_t size): m_data(data), m_size(size) { }
+
+    template<typename U>
+    Span(const std::vector<U>& vector): m_data(vector.data()), m_size(vector.size()) { }
+
+    template<typename U, std::size_t N>
+    Span(U (&array)[N]): m_data(array), m_size(N) { }
+
+    T* begin() const { return m_data; }
+    T* end() const { return m_data + m_size; }
+
+    T& operator[](std::size_t index) const { return m_data[index]; }
+
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+private:
+    T*          m_data;
+    std::size_t m_size;
+};
+
 #endif // COMMON_H_INCLUDED
@@ -2,11 +2,14 @@
 #define COMPONENTS_H_INCLUDED
 
 #include <memory>
+#include <cmath>
+#include <cstdint>
 using std::shared_ptr;
 
 #include "SDL2/SDL.h"
 #include "glm/glm.hpp"
 #include "../../Path.h"
+#include "Common.h"
 
 struct Transform {
     explicit Transform(glm::vec2 objPosition, glm::vec2 objSize, float objScale, float objAngle): position(objPosition),
@@ -20,6 +23,18 @@ struct Transform {
     float angle;
 };
 
+// Transform as it was before the last simulation step
+struct PreviousTransform {
+    glm::vec2 position;
+    float angle;
+};
+
+// Transform interpolated between PreviousTransform and Transform, rendering systems draw this one
+struct RenderTransform {
+    glm::vec2 position;
+    float angle;
+};
+
 struct Renderable {
     explicit Renderable(SDL_Texture* text): texture(text) { }
     SDL_Texture* texture;
@@ -67,6 +82,47 @@ struct Physics {
     glm::vec2 velocity;
 };
 
+/*
+ * Orthonormal frame of a moving entity: local x is along heading, local y along side.
+ * LocalFrameSystem updates it once per tick, so steering doesn't normalise the velocity
+ * for every conversion. The frame matrix is orthonormal, its inverse is its transpose.
+ */
+struct LocalFrame {
+    LocalFrame(): heading(1.0f, 0.0f), side(0.0f, 1.0f) { }
+    explicit LocalFrame(glm::vec2 unitHeading): heading(unitHeading), side(-unitHeading.y, unitHeading.x) { }
+
+    // Along the velocity, or along the angle when (almost) standing still
+    static LocalFrame of(const Transform& transform, const Physics& physics) {
+        float speed = glm::length(physics.velocity);
+        if(speed > 0.01f) {
+            return LocalFrame(physics.velocity * (1.0f / speed));
+        }
+
+        return LocalFrame(glm::vec2(std::cos(transform.angle), std::sin(transform.angle)));
+    }
+
+    glm::vec2 toLocal(glm::vec2 origin, glm::vec2 point) const {
+        glm::vec2 offset = point - origin;
+        return glm::vec2(glm::dot(offset, heading), glm::dot(offset, side));
+    }
+
+    glm::vec2 toWorld(glm::vec2 origin, glm::vec2 point) const {
+        return origin + heading * point.x + side * point.y;
+    }
+
+    // Many points at once, result has to be at least as long as points and may be the same memory
+    void toLocal(glm::vec2 origin, Span<const glm::vec2> points, Span<glm::vec2> result) const {
+        for(std::size_t i = 0; i < points.size(); ++i) result[i] = toLocal(origin, points[i]);
+    }
+
+    void toWorld(glm::vec2 origin, Span<const glm::vec2> points, Span<glm::vec2> result) const {
+        for(std::size_t i = 0; i < points.size(); ++i) result[i] = toWorld(origin, points[i]);
+    }
+
+    glm::vec2 heading;
+    glm::vec2 side;
+};
+
 struct Obstacle {
     Obstacle(SDL_Color t_color): color(t_color) { }
 
@@ -74,7 +130,6 @@ struct Obstacle {
 };
 
 
-#include "Common.h"
 #include "helper.h"
 
 struct Wall {
@@ -93,9 +148,54 @@ struct Wall {
 
 #include "../SteeringManager.h"
 
+// Steering state of an AI agent, SteeringManager(registry, agent) runs the behaviours on it.
+// Avoids obstacles (0.7) and pursues target at an offset (0.3) by default.
 struct AI {
-    explicit AI(shared_ptr<SteeringManager> bmanager) : manager(bmanager) { }
-    shared_ptr<SteeringManager> manager;
+    explicit AI(entt::entity t_target): target(t_target) {
+        settings.enable(SteeringSettings::OBSTACLE_AVOIDANCE, 0.7f);
+        settings.enable(SteeringSettings::OFFSET_PURSUIT, 0.3f);
+    }
+
+    entt::entity        target;
+    SteeringSettings    settings;
+};
+
+// wander() state. Every agent has its own random sequence, so they don't share drand48() between threads.
+struct WanderState {
+    explicit WanderState(unsigned int seed): orientation(0.0f, 0.0f) {
+        // Same layout as srand48()
+        randomState[0] = 0x330E;
+        randomState[1] = seed & 0xFFFF;
+        randomState[2] = (seed >> 16) & 0xFFFF;
+    }
+
+    glm::vec2       orientation;
+    unsigned short  randomState[3];
+};
+
+// Instead of AI: steering by the pipeline registered under id in AISteeringSystem, see SteeringPipeline.h
+struct SteeringArchetype {
+    std::uint16_t   id;
+    entt::entity    target;
+};
+
+// Transform + Kinematic entities which FlockingSystem steers
+struct Boid { };
+
+// OrcaSystem agent: it goes as close to preferredVelocity as it can without hitting others
+struct CrowdAgent {
+    explicit CrowdAgent(float t_radius): radius(t_radius), preferredVelocity(0.0f, 0.0f) { }
+
+    float       radius;
+    glm::vec2   preferredVelocity;
+};
+
+// AISteeringSystem's level of detail state, the system assigns it when SteeringLODSettings is in the context
+struct SteeringLOD {
+    glm::vec2       force = glm::vec2(0.0f, 0.0f);  // last computed, reused while the agent isn't due
+    std::uint16_t   age = 0;                        // ticks since force was computed
+    std::uint8_t    level = 0;
+    bool            computed = false;               // force is valid
 };
 
 #endif // COMPONENTS_H_INCLUDED
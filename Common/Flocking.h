@@ -0,0 +1,251 @@
+#ifndef FLOCKING_H_INCLUDED
+#define FLOCKING_H_INCLUDED
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
+
+#include <glm/glm.hpp>
+#include "entt.hpp"
+
+#include "Components/Components.h"
+#include "SteeringKernels.h"
+#include "ThreadPool.h"
+#include "Tracer.h"
+
+/*
+ * Reynolds' boids: separation, alignment and cohesion of every Boid
+ * (Transform + Kinematic + Boid) computed together in one pass over its
+ * neighbours within radius.
+ *
+ * build() copies the boids into SoA arrays sorted by the cell of a dense
+ * uniform grid over their bounding box (counting sort, cells at least radius
+ * big, so a boid's neighbours lie in the 3x3 cells around it). Cells of a row
+ * are contiguous, so the 3x3 block is three contiguous ranges which
+ * accumulate() walks four neighbours at a time with SteeringKernels' Float4.
+ *
+ * computeAccelerations() runs over chunks of cells in parallel, every boid
+ * only writes its own acceleration, so the result doesn't depend on the
+ * number of threads. A boid skips itself by index, boids at the same
+ * position push each other apart along x.
+ */
+struct FlockingSettings {
+    float radius = 50.0f;
+    float separationWeight = 1.5f;
+    float separationDistance = 10.0f;   // a neighbour this close pushes at maxSpeed, one twice as far at half of it
+    float alignmentWeight = 1.0f;
+    float cohesionWeight = 1.0f;
+};
+
+class FlockGrid {
+public:
+    void build(entt::registry& registry, float radius) {
+        m_boids.clear();
+        registry.view<Transform, Kinematic, Boid>().each([&](entt::entity entity, Transform& transform, Kinematic& kinematic, auto) {
+            m_boids.push_back(Gathered{entity, transform.position, kinematic.velocity, kinematic.maxSpeed, kinematic.maxAcceleration});
+        });
+
+        std::size_t count = m_boids.size();
+        if(count == 0) {
+            m_cellStart.assign(1, 0);
+            m_sorted.clear();
+            m_width = m_height = 0;
+            return;
+        }
+
+        glm::vec2 min = m_boids[0].position, max = min;
+        for(const Gathered& boid: m_boids) {
+            min = glm::min(min, boid.position);
+            max = glm::max(max, boid.position);
+        }
+
+        // Cells of radius, bigger if the grid would have many more cells than boids
+        glm::vec2 extent = max - min;
+        m_cellSize = std::max({radius, 1.0f, std::sqrt(extent.x * extent.y / float(MAX_CELLS_PER_BOID * count))});
+        m_origin = min;
+        m_width = int(extent.x / m_cellSize) + 1;
+        m_height = int(extent.y / m_cellSize) + 1;
+
+        m_cells.resize(count);
+        m_cellStart.assign(std::size_t(m_width) * m_height + 1, 0);
+        for(std::size_t i = 0; i < count; ++i) {
+            m_cells[i] = cellOf(m_boids[i].position);
+            ++m_cellStart[m_cells[i] + 1];
+        }
+        for(std::size_t cell = 1; cell < m_cellStart.size(); ++cell) {
+            m_cellStart[cell] += m_cellStart[cell - 1];
+        }
+
+        // Stable scatter into the SoA arrays
+        m_fill.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+        m_sorted.resize(count);
+        for(auto array: {&m_positionX, &m_positionY, &m_velocityX, &m_velocityY, &m_maxSpeed, &m_maxAcceleration}) {
+            array->resize(count);
+        }
+
+        for(std::size_t i = 0; i < count; ++i) {
+            std::size_t slot = m_fill[m_cells[i]]++;
+            const Gathered& boid = m_boids[i];
+
+            m_sorted[slot] = boid.entity;
+            m_positionX[slot] = boid.position.x;
+            m_positionY[slot] = boid.position.y;
+            m_velocityX[slot] = boid.velocity.x;
+            m_velocityY[slot] = boid.velocity.y;
+            m_maxSpeed[slot] = boid.maxSpeed;
+            m_maxAcceleration[slot] = boid.maxAcceleration;
+        }
+    }
+
+    // Acceleration of every boid in getEntities() order, no longer than its Kinematic::maxAcceleration.
+    // vectorised = false accumulates one neighbour at a time, for comparison.
+    void computeAccelerations(const FlockingSettings& settings, ThreadPool& pool, bool vectorised = true) {
+        m_accelerations.resize(m_sorted.size());
+        std::size_t cellsCount = m_cellStart.size() - 1;
+
+        pool.parallelFor(cellsCount, CELLS_PER_TASK, [&](std::size_t begin, std::size_t end) {
+            TRACE_SCOPE("compute", "FlockingSystem");
+            for(std::size_t cell = begin; cell < end; ++cell) {
+                for(std::size_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i) {
+                    m_accelerations[i] = vectorised ? computeBoid<VectorLanes>(settings, cell, i)
+                                                    : computeBoid<float>(settings, cell, i);
+                }
+            }
+        });
+    }
+
+    const std::vector<entt::entity>& getEntities() const { return m_sorted; }
+    const std::vector<glm::vec2>& getAccelerations() const { return m_accelerations; }
+
+private:
+#ifdef __SSE2__
+    using VectorLanes = sk::Float4;
+#else
+    using VectorLanes = float;
+#endif
+
+    struct Gathered {
+        entt::entity    entity;
+        glm::vec2       position;
+        glm::vec2       velocity;
+        float           maxSpeed;
+        float           maxAcceleration;
+    };
+
+    template<typename T>
+    struct Sums {
+        sk::Vector<T>   separation{T(0.0f), T(0.0f)};
+        sk::Vector<T>   velocity{T(0.0f), T(0.0f)};
+        sk::Vector<T>   position{T(0.0f), T(0.0f)};
+        T               count = T(0.0f);
+    };
+
+    static constexpr std::size_t CELLS_PER_TASK = 256;
+    static constexpr std::size_t MAX_CELLS_PER_BOID = 4;
+
+    // Boids at the same position push each other apart along x as if they were this far, lower index to the left
+    static constexpr float COINCIDENT_OFFSET = 0.001f;
+
+    std::size_t cellOf(glm::vec2 position) const {
+        int x = std::min(int((position.x - m_origin.x) / m_cellSize), m_width - 1);
+        int y = std::min(int((position.y - m_origin.y) / m_cellSize), m_height - 1);
+        return std::size_t(y) * m_width + x;
+    }
+
+    // Neighbours [begin, end) of the boid at (x, y) within radius: T lanes at a time, the rest one by one.
+    // The range mustn't contain the boid itself. A neighbour at the same position pushes it towards +x * side,
+    // they share a cell, so only the ranges right before and after the boid need the right side.
+    template<typename T>
+    void accumulate(std::size_t begin, std::size_t end, float x, float y, float side, float radiusSquared,
+                    Sums<T>& lanes, Sums<float>& single) const {
+        auto add = [&](auto zero, std::size_t j, auto& sums) {
+            using L = decltype(zero);
+            sk::Vector<L> position{sk::load(L(), m_positionX.data() + j), sk::load(L(), m_positionY.data() + j)};
+            sk::Vector<L> velocity{sk::load(L(), m_velocityX.data() + j), sk::load(L(), m_velocityY.data() + j)};
+            sk::Vector<L> away = sk::Vector<L>{L(x), L(y)} - position;
+
+            L coincident = sk::select(sk::dot(away, away) > L(0.0f), L(0.0f), L(1.0f));
+            away.x = away.x + coincident * L(side * COINCIDENT_OFFSET);
+
+            L distanceSquared = sk::dot(away, away);
+            L inside = sk::select(L(radiusSquared) > distanceSquared, L(1.0f), L(0.0f));
+            L inverse = inside / distanceSquared;
+
+            sums.separation = sums.separation + away * inverse;
+            sums.velocity = sums.velocity + velocity * inside;
+            sums.position = sums.position + position * inside;
+            sums.count = sums.count + inside;
+        };
+
+        std::size_t j = begin;
+        if constexpr(!std::is_same<T, float>::value) {
+            for(; j + 4 <= end; j += 4) add(T(), j, lanes);
+        }
+        for(; j < end; ++j) add(0.0f, j, single);
+    }
+
+    template<typename T>
+    glm::vec2 computeBoid(const FlockingSettings& settings, std::size_t cell, std::size_t i) const {
+        int cellX = int(cell % m_width), cellY = int(cell / m_width);
+        float x = m_positionX[i], y = m_positionY[i];
+
+        Sums<T> lanes;
+        Sums<float> single;
+        for(int row = std::max(cellY - 1, 0); row <= std::min(cellY + 1, m_height - 1); ++row) {
+            std::size_t first = std::size_t(row) * m_width + std::max(cellX - 1, 0);
+            std::size_t last = std::size_t(row) * m_width + std::min(cellX + 1, m_width - 1);
+            std::size_t begin = m_cellStart[first], end = m_cellStart[last + 1];
+            float radiusSquared = settings.radius * settings.radius;
+
+            // Around the boid itself, by index: a boid at the same position is still a neighbour
+            if(begin <= i && i < end) {
+                accumulate(begin, i, x, y, 1.0f, radiusSquared, lanes, single);
+                accumulate(i + 1, end, x, y, -1.0f, radiusSquared, lanes, single);
+            } else {
+                accumulate(begin, end, x, y, 1.0f, radiusSquared, lanes, single);
+            }
+        }
+
+        float count = sk::horizontalSum(lanes.count) + single.count;
+        if(count == 0.0f) {
+            return glm::vec2(0.0f, 0.0f);
+        }
+
+        auto total = [](const sk::Vector<T>& a, const sk::Vector<float>& b) {
+            return glm::vec2(sk::horizontalSum(a.x) + b.x, sk::horizontalSum(a.y) + b.y);
+        };
+
+        glm::vec2 position(x, y), velocity(m_velocityX[i], m_velocityY[i]);
+        float maxSpeed = m_maxSpeed[i];
+
+        // Separation pushes away by the summed 1/distance of the neighbours, so far ones barely count and opposite
+        // ones cancel out. Alignment and cohesion steer towards their desired velocity.
+        glm::vec2 separation = wrapVector(total(lanes.separation, single.separation) * (settings.separationDistance * maxSpeed),
+                                          maxSpeed);
+        glm::vec2 alignment = total(lanes.velocity, single.velocity) / count - velocity;
+        glm::vec2 cohesion = safeNormalize(total(lanes.position, single.position) / count - position) * maxSpeed - velocity;
+
+        return wrapVector(separation * settings.separationWeight + alignment * settings.alignmentWeight +
+                          cohesion * settings.cohesionWeight, m_maxAcceleration[i]);
+    }
+
+    std::vector<Gathered>       m_boids;        // view order
+    std::vector<std::size_t>    m_cells;        // of m_boids
+    std::vector<std::size_t>    m_cellStart;
+    std::vector<std::size_t>    m_fill;
+
+    glm::vec2                   m_origin;
+    float                       m_cellSize = 1.0f;
+    int                         m_width = 0;
+    int                         m_height = 0;
+
+    // Sorted by cell
+    std::vector<entt::entity>   m_sorted;
+    std::vector<float>          m_positionX, m_positionY;
+    std::vector<float>          m_velocityX, m_velocityY;
+    std::vector<float>          m_maxSpeed, m_maxAcceleration;
+    std::vector<glm::vec2>      m_accelerations;
+};
+
+#endif // FLOCKING_H_INCLUDED
@@ -0,0 +1,191 @@
+#ifndef FRAMEPACER_H_INCLUDED
+#define FRAMEPACER_H_INCLUDED
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+
+/*
+ * Decides when the next frame starts.
+ *
+ * UNTHROTTLED - next frame right away.
+ * VSYNC       - SDL_RenderPresent() blocks until the vertical blank, the pacer
+ *               only measures (the renderer has to be created with
+ *               SDL_RENDERER_PRESENTVSYNC).
+ * SLEEP       - sleeps until the frame deadline minus the spin threshold, then
+ *               yields in a loop for the rest: sleep_for() alone oversleeps by
+ *               up to a scheduler tick. Deadlines advance by the frame time from
+ *               the previous deadline, so errors don't accumulate.
+ *
+ * Usage per frame: delta = beginFrame(), update and render, endFrame().
+ */
+enum class PacingMode { UNTHROTTLED, VSYNC, SLEEP };
+
+class FramePacer {
+public:
+    // Over the last HISTORY_SIZE frames
+    struct Stats {
+        std::size_t frames;
+        double      meanFrameTime;      // seconds
+        double      minFrameTime;
+        double      maxFrameTime;
+        double      meanError;          // mean |frame time - target|, 0 for UNTHROTTLED
+        double      maxError;
+        double      busyFraction;       // update + render
+        double      sleepFraction;      // the CPU was given away
+        double      spinFraction;       // waiting, but burning the CPU
+    };
+
+    FramePacer(): m_mode(PacingMode::UNTHROTTLED), m_targetFrameTime(1.0 / 60.0), m_spinThreshold(0.002),
+                  m_started(false), m_busyTime(0.0), m_sleepTime(0.0), m_spinTime(0.0), m_next(0) { }
+
+    void setMode(PacingMode mode, double targetFps = 60.0) {
+        m_mode = mode;
+        m_targetFrameTime = (targetFps > 0.0) ? 1.0 / targetFps : 0.0;
+        m_started = false;
+    }
+
+    // The last part of a SLEEP wait which is spent yielding instead of sleeping
+    void setSpinThreshold(double seconds) { m_spinThreshold = seconds; }
+
+    PacingMode getMode() const { return m_mode; }
+
+    // Seconds since the previous beginFrame()
+    double beginFrame() {
+        Clock::time_point now = Clock::now();
+        double delta = 0.0;
+
+        if(m_started) {
+            delta = seconds(now - m_frameStart);
+            record(delta);
+        } else {
+            m_deadline = now;
+            m_started = true;
+        }
+
+        m_frameStart = now;
+        m_sleepTime = 0.0;
+        m_spinTime = 0.0;
+
+        return delta;
+    }
+
+    void endFrame() {
+        Clock::time_point now = Clock::now();
+        m_busyTime = seconds(now - m_frameStart);
+
+        if(m_mode != PacingMode::SLEEP || m_targetFrameTime <= 0.0) return;
+
+        m_deadline += toDuration(m_targetFrameTime);
+
+        // More than a frame late: start counting from now instead of rushing to catch up
+        if(now > m_deadline + toDuration(m_targetFrameTime)) {
+            m_deadline = now;
+            return;
+        }
+
+        Clock::duration spin = toDuration(m_spinThreshold);
+        if(m_deadline - now > spin) {
+            std::this_thread::sleep_for(m_deadline - now - spin);
+
+            Clock::time_point woken = Clock::now();
+            m_sleepTime = seconds(woken - now);
+            now = woken;
+        }
+
+        while(now < m_deadline) {
+            std::this_thread::yield();
+            now = Clock::now();
+        }
+
+        m_spinTime = seconds(now - m_frameStart) - m_busyTime - m_sleepTime;
+    }
+
+    Stats getStats() const {
+        Stats stats{m_next < HISTORY_SIZE ? m_next : HISTORY_SIZE, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+        if(stats.frames == 0) return stats;
+
+        double totalTime = 0.0, busyTime = 0.0, sleepTime = 0.0, spinTime = 0.0;
+        stats.minFrameTime = m_history[0].frameTime;
+        for(auto i = 0u; i < stats.frames; ++i) {
+            const Frame& frame = m_history[i];
+            totalTime += frame.frameTime;
+            busyTime += frame.busyTime;
+            sleepTime += frame.sleepTime;
+            spinTime += frame.spinTime;
+
+            stats.minFrameTime = std::min(stats.minFrameTime, frame.frameTime);
+            stats.maxFrameTime = std::max(stats.maxFrameTime, frame.frameTime);
+
+            if(m_mode != PacingMode::UNTHROTTLED && m_targetFrameTime > 0.0) {
+                double error = std::fabs(frame.frameTime - m_targetFrameTime);
+                stats.meanError += error;
+                stats.maxError = std::max(stats.maxError, error);
+            }
+        }
+
+        stats.meanFrameTime = totalTime / stats.frames;
+        stats.meanError /= stats.frames;
+        stats.busyFraction = busyTime / totalTime;
+        stats.sleepFraction = sleepTime / totalTime;
+        stats.spinFraction = spinTime / totalTime;
+
+        return stats;
+    }
+
+    void printStats() const {
+        Stats stats = getStats();
+        printf("%zu frames: %.3f ms mean (%.3f - %.3f), error %.3f ms mean / %.3f ms max, "
+               "busy %.1f%%, sleeping %.1f%%, spinning %.1f%%\n",
+               stats.frames, stats.meanFrameTime * 1000.0, stats.minFrameTime * 1000.0, stats.maxFrameTime * 1000.0,
+               stats.meanError * 1000.0, stats.maxError * 1000.0,
+               stats.busyFraction * 100.0, stats.sleepFraction * 100.0, stats.spinFraction * 100.0);
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t HISTORY_SIZE = 240;
+
+    struct Frame {
+        double frameTime;
+        double busyTime;
+        double sleepTime;
+        double spinTime;
+    };
+
+    static double seconds(Clock::duration duration) {
+        return std::chrono::duration<double>(duration).count();
+    }
+
+    static Clock::duration toDuration(double seconds) {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    }
+
+    void record(double frameTime) {
+        if(m_history.size() < HISTORY_SIZE) m_history.resize(HISTORY_SIZE);
+
+        m_history[m_next % HISTORY_SIZE] = Frame{frameTime, m_busyTime, m_sleepTime, m_spinTime};
+        m_next++;
+    }
+
+    PacingMode          m_mode;
+    double              m_targetFrameTime;
+    double              m_spinThreshold;
+
+    bool                m_started;
+    Clock::time_point   m_frameStart;
+    Clock::time_point   m_deadline;
+
+    double              m_busyTime;
+    double              m_sleepTime;
+    double              m_spinTime;
+
+    std::vector<Frame>  m_history;
+    std::size_t         m_next;
+};
+
+#endif // FRAMEPACER_H_INCLUDED
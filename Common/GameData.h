@@ -1,6 +1,8 @@
 #ifndef GAMEDATA_H_INCLUDED
 #define GAMEDATA_H_INCLUDED
 
+#include <cstddef>
+
 #include "glm/glm.hpp"
 
 struct GameData {
@@ -10,4 +12,42 @@ struct GameData {
 
 };
 
+// Where the rendered frame lies between the previous (0) and the last (1) simulation step
+struct RenderInterpolation {
+    RenderInterpolation(): alpha(1.0f) { }
+
+    float alpha;
+};
+
+/*
+ * AISteeringSystem level of detail, used when it's in the registry context.
+ *
+ * An agent's level is the number of levelDistances it is further from the
+ * player (Controllable, focus without one) than, a moving Obstacle closer
+ * than threatDistance takes it back to level 0. Agents of level L are computed
+ * every intervals[L] ticks and reuse their last force in between.
+ *
+ * budgetMicroseconds limits the compute phase of a tick: due agents are
+ * computed nearest level first (ones deferred before go first within a level)
+ * and once the budget is spent the rest wait for the next tick. Level 0 is
+ * always computed. 0 means no budget.
+ */
+struct SteeringLODSettings {
+    static constexpr int LEVELS_COUNT = 4;
+
+    float       levelDistances[LEVELS_COUNT - 1] = {400.0f, 1000.0f, 2500.0f};
+    int         intervals[LEVELS_COUNT] = {1, 2, 4, 8};
+    float       threatDistance = 100.0f;
+    glm::vec2   focus = glm::vec2(0.0f, 0.0f);
+    double      budgetMicroseconds = 0.0;
+};
+
+// What AISteeringSystem did with the LOD last tick, per level
+struct SteeringLODStats {
+    std::size_t agents[SteeringLODSettings::LEVELS_COUNT] = {};
+    std::size_t updated[SteeringLODSettings::LEVELS_COUNT] = {};
+    std::size_t deferred[SteeringLODSettings::LEVELS_COUNT] = {};  // due, but over the budget
+    double      computeMicroseconds = 0.0;
+};
+
 #endif // GAMEDATA_H_INCLUDED
@@ -4,12 +4,16 @@
 
 #include <iostream>
 #include <chrono>
+#include <cmath>
+#include <algorithm>
 
 #include "SystemsManager.h"
 #include "Systems/System.h"
 #include "Events/Events.h"
 
 #include "GameData.h"
+#include "FramePacer.h"
+#include "Tracer.h"
 
 #include "SDL2/SDL_image.h"
 
@@ -20,61 +24,122 @@ const int SCREEN_HEIGHT = 480;
 
 class GameManager {
 public:
-    GameManager(): m_pwindow(NULL), m_prenderer(NULL), m_fpsLimit(9999), m_fps(0) { }
+    GameManager(): m_pwindow(NULL), m_prenderer(NULL), m_headless(false), m_fixedDelta(0.0f), m_maxStepsPerFrame(5),
+                   m_accumulator(0.0), m_droppedTime(0.0), m_fps(0) {
+        m_pacer.setMode(PacingMode::SLEEP, 60.0);
+    }
     ~GameManager() {
 
         for(auto texture : m_vtextures) {
             SDL_DestroyTexture(texture);
         }
 
-        SDL_DestroyRenderer(m_prenderer);
+        if(m_prenderer != NULL) SDL_DestroyRenderer(m_prenderer);
 
         if(m_pwindow != NULL) SDL_DestroyWindow(m_pwindow);
-        SDL_Quit();
+        if(!m_headless) SDL_Quit();
     }
 
+    // Headless games don't touch SDL at all: no window, no renderer, no events.
+    // Has to be set before init().
+    void setHeadless(bool headless) { m_headless = headless; }
+    bool isHeadless() const { return m_headless; }
+
     virtual bool init(const string& programName, int width, int height) {
+        if(m_headless) {
+            m_screenWidth = width;
+            m_screenHeight = height;
+            return true;
+        }
+
         if(!initSDL(m_pwindow, programName.c_str(), width, height)) return false;
 
         return true;
     }
 
 
+    // Fixed timestep mode: simulate() runs ticksPerSecond times per second of real time, at most
+    // maxStepsPerFrame times per frame (the rest is dropped), then render() interpolates.
+    // Zero ticksPerSecond goes back to update() with a variable delta.
+    void setFixedTimestep(float ticksPerSecond, uint32_t maxStepsPerFrame = 5) {
+        m_fixedDelta = (ticksPerSecond > 0.0f) ? 1.0f / ticksPerSecond : 0.0f;
+        m_maxStepsPerFrame = std::max(maxStepsPerFrame, 1u);
+        m_accumulator = 0.0;
+    }
+
+    // VSYNC has to be chosen before init(), it's a property of the renderer. Headless games have
+    // nothing to sync with and sleep instead.
+    void setFramePacing(PacingMode mode, double targetFps = 60.0) {
+        if(mode == PacingMode::VSYNC && m_headless) mode = PacingMode::SLEEP;
+        m_pacer.setMode(mode, targetFps);
+    }
+
+    const FramePacer& getFramePacer() const { return m_pacer; }
+    SystemsManager& getSystemsManager() { return m_systemsManager; }
+
     void run() {
-        std::chrono::time_point<std::chrono::system_clock> lastTime, currentTime;
-        currentTime = lastTime = std::chrono::system_clock::now();
         double elapsedTime = 0.0;
-
         uint32_t fps = 0;
 
-        std::chrono::duration<double> diff;
-
         m_gameFinished = false;
         while(!m_gameFinished) {
-            //physics update should be unlimited!
-            lastTime = currentTime;
-            currentTime = std::chrono::system_clock::now();
-            diff = currentTime - lastTime;
-            double delta = diff.count();
-
-            if(elapsedTime < 1.0) {
-                if(fps < m_fpsLimit) {
-                    pollEvents();
-                    update(delta);
+            double delta = m_pacer.beginFrame();
+            Tracer::getInstance().nextFrame();
 
-                    fps++;
-                }
+            pollEvents();
 
-                elapsedTime += delta;
+            if(m_fixedDelta > 0.0f) {
+                stepFixed(delta);
             } else {
+                update(delta);
+            }
+
+            fps++;
+            elapsedTime += delta;
+            if(elapsedTime >= 1.0) {
                 m_fps = fps;
                 elapsedTime = 0;
                 fps = 0;
             }
+
+            m_pacer.endFrame();
         }
     }
 
-    virtual void update(float delta) { }
+    // Ticks with a fixed delta as fast as possible, until ticksCount ticks or durationSeconds
+    // have passed (zero means no limit). Returns ticks per second.
+    double runHeadless(uint64_t ticksCount, double durationSeconds, float delta = 1.0f / 60.0f) {
+        auto startTime = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed(0.0);
+        uint64_t ticks = 0;
+
+        m_gameFinished = false;
+        while(!m_gameFinished && (ticksCount == 0 || ticks < ticksCount) &&
+              (durationSeconds <= 0.0 || elapsed.count() < durationSeconds)) {
+            Tracer::getInstance().nextFrame();
+            simulate(delta);
+            ticks++;
+
+            elapsed = std::chrono::steady_clock::now() - startTime;
+        }
+
+        double ticksPerSecond = (elapsed.count() > 0.0) ? ticks / elapsed.count() : 0.0;
+        printf("%llu ticks in %.3f s, %.1f ticks/s\n", (unsigned long long)ticks, elapsed.count(), ticksPerSecond);
+
+        return ticksPerSecond;
+    }
+
+    // Variable timestep: one simulation step per frame, nothing to interpolate
+    virtual void update(float delta) {
+        simulate(delta);
+        render(1.0f, delta);
+    }
+
+    virtual void simulate(float delta) { }
+
+    // alpha in [0, 1]: where the frame lies between the previous and the last simulation step,
+    // delta is the real time since the previous frame
+    virtual void render(float alpha, float delta) { }
 
     virtual void input(SDL_Event event) { }
 
@@ -94,6 +159,9 @@ public:
 
     uint32_t getFPS() const { return m_fps; }
 
+    // Simulation time skipped so far because a frame needed more than maxStepsPerFrame steps
+    double getDroppedTime() const { return m_droppedTime; }
+
 protected:
     SystemsManager m_systemsManager;
     SDL_Window* m_pwindow;
@@ -122,7 +190,10 @@ private:
                 return false;
             }
 
-            m_prenderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+            Uint32 rendererFlags = SDL_RENDERER_ACCELERATED;
+            if(m_pacer.getMode() == PacingMode::VSYNC) rendererFlags |= SDL_RENDERER_PRESENTVSYNC;
+
+            m_prenderer = SDL_CreateRenderer(window, -1, rendererFlags);
             if(m_prenderer == NULL) return false;
 
             if(!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
@@ -136,14 +207,40 @@ private:
 
     }
 
+    void stepFixed(double frameDelta) {
+        m_accumulator += frameDelta;
+
+        uint32_t steps = 0;
+        while(m_accumulator >= m_fixedDelta && steps < m_maxStepsPerFrame) {
+            simulate(m_fixedDelta);
+            m_accumulator -= m_fixedDelta;
+            steps++;
+        }
+
+        // Still behind after the last allowed step: give up on that time instead of spiralling
+        if(m_accumulator >= m_fixedDelta) {
+            double kept = std::fmod(m_accumulator, double(m_fixedDelta));
+            m_droppedTime += m_accumulator - kept;
+            m_accumulator = kept;
+        }
+
+        render(float(m_accumulator / m_fixedDelta), float(frameDelta));
+    }
+
     void showLastError(const char* message) {
         printf("%s: %s\n", message, SDL_GetError());
     }
 
 
     bool m_gameFinished;
+    bool m_headless;
+
+    float m_fixedDelta;
+    uint32_t m_maxStepsPerFrame;
+    double m_accumulator;
+    double m_droppedTime;
 
-    uint32_t m_fpsLimit;
+    FramePacer m_pacer;
     uint32_t m_fps;
 
     vector<SDL_Texture*> m_vtextures;
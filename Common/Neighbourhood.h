@@ -0,0 +1,125 @@
+#ifndef NEIGHBOURHOOD_H_INCLUDED
+#define NEIGHBOURHOOD_H_INCLUDED
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include "entt.hpp"
+
+#include "Common.h"
+#include "SpatialHashGrid.h"
+#include "Components/Components.h"
+
+/*
+ * Neighbour lists of all kinematic agents (Transform + Kinematic).
+ *
+ * build() is called once per tick (NeighbourhoodSystem) and stores, for each
+ * agent, every other agent within radius - or only the maxNeighbours nearest
+ * ones, sorted by distance. Lists are packed into one array, so get() returns
+ * a span into it without any allocation.
+ *
+ * A neighbour is a snapshot of the agent at build time, behaviours don't have
+ * to touch the registry for their targets at all. They don't see anybody
+ * beyond radius either, so it has to cover their reach (see
+ * sb::collisionAvoidance).
+ */
+struct Neighbour {
+    entt::entity    entity;
+    glm::vec2       position;
+    glm::vec2       velocity;
+    float           distance;
+};
+
+class Neighbourhood {
+public:
+    // maxNeighbours == 0 means "everybody within radius"
+    explicit Neighbourhood(float radius = 100.0f, std::size_t maxNeighbours = 0): m_grid(radius),
+                                                                                  m_radius(radius),
+                                                                                  m_maxNeighbours(maxNeighbours) { }
+
+    void build(entt::registry& registry) {
+        m_grid.clear();
+
+        auto agentsView = registry.view<Transform, Kinematic>();
+        agentsView.each([&](entt::entity agent, Transform& transform, Kinematic& kinematic) {
+            m_grid.insert(agent, transform.position, 0.0f);
+        });
+
+        m_grid.build();
+
+        m_neighbours.clear();
+        m_offsets.assign(1, 0);
+        m_slots.clear();
+
+        const auto& agents = m_grid.getItems();
+        for(auto slot = 0u; slot < agents.size(); ++slot) {
+            const auto& agent = agents[slot];
+
+            auto index = entt::to_integral(registry.entity(agent.entity));
+            if(index >= m_slots.size()) m_slots.resize(index + 1, NO_SLOT);
+            m_slots[index] = slot;
+
+            std::size_t first = m_neighbours.size();
+            m_grid.queryRadius(agent.position, m_radius, [&](const SpatialHashGrid::Item& item) {
+                if(item.entity == agent.entity) return;
+
+                const Kinematic& kinematic = agentsView.get<Kinematic>(item.entity);
+                m_neighbours.push_back(Neighbour{item.entity, item.position, kinematic.velocity,
+                                                 glm::distance(agent.position, item.position)});
+            });
+
+            if(m_maxNeighbours > 0 && m_neighbours.size() - first > m_maxNeighbours) {
+                auto begin = m_neighbours.begin() + first;
+                std::partial_sort(begin, begin + m_maxNeighbours, m_neighbours.end(),
+                                  [](const Neighbour& a, const Neighbour& b) { return a.distance < b.distance; });
+                m_neighbours.resize(first + m_maxNeighbours);
+            }
+
+            m_offsets.push_back(m_neighbours.size());
+        }
+    }
+
+    // Neighbours of the agent found during the last build(), empty for unknown agents
+    Span<const Neighbour> get(entt::entity agent) const {
+        auto index = entt::to_integral(entt::registry::entity(agent));
+        if(index >= m_slots.size() || m_slots[index] == NO_SLOT) return Span<const Neighbour>();
+
+        std::uint32_t slot = m_slots[index];
+        if(m_grid.getItems()[slot].entity != agent) return Span<const Neighbour>();
+
+        return Span<const Neighbour>(m_neighbours.data() + m_offsets[slot], m_offsets[slot + 1] - m_offsets[slot]);
+    }
+
+    // Agents positions within an arbitrary radius, as they were during the last build()
+    template<typename Callback>
+    void forEachInRadius(glm::vec2 position, float radius, Callback callback) const {
+        m_grid.queryRadius(position, radius, [&](const SpatialHashGrid::Item& item) {
+            callback(item.entity, item.position);
+        });
+    }
+
+    void setRadius(float radius) {
+        m_radius = radius;
+        m_grid = SpatialHashGrid(radius);
+    }
+
+    void setMaxNeighbours(std::size_t maxNeighbours) { m_maxNeighbours = maxNeighbours; }
+
+    float getRadius() const { return m_radius; }
+    std::size_t getMaxNeighbours() const { return m_maxNeighbours; }
+
+private:
+    static constexpr std::uint32_t NO_SLOT = 0xFFFFFFFF;
+
+    SpatialHashGrid             m_grid;
+    float                       m_radius;
+    std::size_t                 m_maxNeighbours;
+
+    std::vector<Neighbour>      m_neighbours;
+    std::vector<std::size_t>    m_offsets;
+    std::vector<std::uint32_t>  m_slots;    // entity index -> agent slot
+};
+
+#endif // NEIGHBOURHOOD_H_INCLUDED
@@ -0,0 +1,295 @@
+#ifndef ORCA_H_INCLUDED
+#define ORCA_H_INCLUDED
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include "entt.hpp"
+
+#include "SpatialHashGrid.h"
+#include "ThreadPool.h"
+#include "Tracer.h"
+
+/*
+ * Optimal reciprocal collision avoidance (van den Berg et al., "Reciprocal
+ * n-body collision avoidance"): every agent takes half of the responsibility
+ * for avoiding each of its neighbours. A neighbour gives a half-plane of
+ * velocities (an ORCA line) which keep the pair apart for timeHorizon seconds,
+ * the new velocity is the one nearest to the preferred velocity which lies in
+ * all half-planes and within maxSpeed - a 2D linear program solved
+ * incrementally (linearProgram2). If the half-planes have no common point,
+ * linearProgram3 finds the velocity which violates them the least.
+ *
+ * solve() works on a snapshot (getAgents()), the maxNeighbours nearest agents
+ * within neighbourDistance come from a SpatialHashGrid. Agents are solved in
+ * parallel, each one writes only its own velocity, so results don't depend on
+ * the number of threads.
+ */
+struct OrcaSettings {
+    float       timeHorizon = 1.0f;         // seconds the chosen velocities are collision free for
+    float       neighbourDistance = 60.0f;
+    std::size_t maxNeighbours = 10;
+};
+
+class OrcaSolver {
+public:
+    struct Agent {
+        glm::vec2   position;
+        glm::vec2   velocity;
+        glm::vec2   preferredVelocity;
+        float       radius;
+        float       maxSpeed;
+    };
+
+    std::vector<Agent>& getAgents() { return m_agents; }
+
+    // New velocities of getAgents() in the same order, the step is the simulation delta
+    void solve(const OrcaSettings& settings, float timeStep, ThreadPool& pool) {
+        // Cells as big as the neighbour distance, a query touches only the cells around the agent's one
+        if(m_grid.getCellSize() != settings.neighbourDistance) {
+            m_grid = SpatialHashGrid(settings.neighbourDistance);
+        }
+
+        m_grid.clear();
+        for(std::size_t i = 0; i < m_agents.size(); ++i) {
+            m_grid.insert(entt::entity(std::uint32_t(i)), m_agents[i].position, m_agents[i].radius);
+        }
+        m_grid.build();
+
+        m_velocities.resize(m_agents.size());
+        pool.parallelFor(m_agents.size(), AGENTS_PER_TASK, [&](std::size_t begin, std::size_t end) {
+            TRACE_SCOPE("solve", "OrcaSolver");
+            for(auto i = begin; i < end; ++i) {
+                m_velocities[i] = solveAgent(settings, timeStep, i);
+            }
+        });
+    }
+
+    const std::vector<glm::vec2>& getVelocities() const { return m_velocities; }
+
+private:
+    static constexpr std::size_t AGENTS_PER_TASK = 256;
+    static constexpr std::size_t MAX_LINES = 32;
+    static constexpr float EPSILON = 0.00001f;
+
+    // Allowed velocities are on the left of direction
+    struct Line {
+        glm::vec2 point;
+        glm::vec2 direction;
+    };
+
+    struct Candidate {
+        float           distanceSquared;
+        std::uint32_t   index;
+    };
+
+    static float det(glm::vec2 a, glm::vec2 b) { return a.x * b.y - a.y * b.x; }
+
+    glm::vec2 solveAgent(const OrcaSettings& settings, float timeStep, std::size_t index) const {
+        const Agent& agent = m_agents[index];
+        std::size_t maxNeighbours = std::min(settings.maxNeighbours, MAX_LINES);
+
+        // Nearest neighbours, sorted by insertion
+        Candidate neighbours[MAX_LINES];
+        std::size_t neighboursCount = 0;
+        float range = settings.neighbourDistance;
+        m_grid.queryRadius(agent.position, range, [&](const SpatialHashGrid::Item& item) {
+            std::uint32_t other = entt::to_integral(item.entity);
+            if(other == index || maxNeighbours == 0) return;
+
+            glm::vec2 offset = item.position - agent.position;
+            float distanceSquared = glm::dot(offset, offset);
+            if(neighboursCount == maxNeighbours && distanceSquared >= neighbours[neighboursCount - 1].distanceSquared) return;
+
+            std::size_t slot = std::min(neighboursCount, maxNeighbours - 1);
+            while(slot > 0 && neighbours[slot - 1].distanceSquared > distanceSquared) {
+                neighbours[slot] = neighbours[slot - 1];
+                --slot;
+            }
+            neighbours[slot] = Candidate{distanceSquared, other};
+            neighboursCount = std::min(neighboursCount + 1, maxNeighbours);
+        });
+
+        Line lines[MAX_LINES];
+        float inverseHorizon = 1.0f / settings.timeHorizon;
+
+        for(std::size_t n = 0; n < neighboursCount; ++n) {
+            const Agent& other = m_agents[neighbours[n].index];
+
+            glm::vec2 relativePosition = other.position - agent.position;
+            glm::vec2 relativeVelocity = agent.velocity - other.velocity;
+            float distanceSquared = glm::dot(relativePosition, relativePosition);
+            float combinedRadius = agent.radius + other.radius;
+            float combinedRadiusSquared = combinedRadius * combinedRadius;
+
+            Line& line = lines[n];
+            glm::vec2 u;
+
+            if(distanceSquared > combinedRadiusSquared) {
+                // From the cut-off circle center (relative position scaled by the horizon) to the relative velocity
+                glm::vec2 w = relativeVelocity - relativePosition * inverseHorizon;
+                float wLengthSquared = glm::dot(w, w);
+                float dotProduct = glm::dot(w, relativePosition);
+
+                if(dotProduct < 0.0f && dotProduct * dotProduct > combinedRadiusSquared * wLengthSquared) {
+                    // Nearest to the cut-off circle
+                    float wLength = std::sqrt(wLengthSquared);
+                    glm::vec2 unitW = w / wLength;
+
+                    line.direction = glm::vec2(unitW.y, -unitW.x);
+                    u = unitW * (combinedRadius * inverseHorizon - wLength);
+                } else {
+                    // Nearest to one of the legs of the cone
+                    float leg = std::sqrt(distanceSquared - combinedRadiusSquared);
+
+                    if(det(relativePosition, w) > 0.0f) {
+                        line.direction = glm::vec2(relativePosition.x * leg - relativePosition.y * combinedRadius,
+                                                   relativePosition.x * combinedRadius + relativePosition.y * leg) / distanceSquared;
+                    } else {
+                        line.direction = -glm::vec2(relativePosition.x * leg + relativePosition.y * combinedRadius,
+                                                    -relativePosition.x * combinedRadius + relativePosition.y * leg) / distanceSquared;
+                    }
+
+                    u = line.direction * glm::dot(relativeVelocity, line.direction) - relativeVelocity;
+                }
+            } else {
+                // Already overlapping: get apart within this step
+                float inverseStep = 1.0f / timeStep;
+                glm::vec2 w = relativeVelocity - relativePosition * inverseStep;
+                float wLength = glm::length(w);
+                glm::vec2 unitW = (wLength > EPSILON) ? w / wLength : glm::vec2(0.0f, 1.0f);
+
+                line.direction = glm::vec2(unitW.y, -unitW.x);
+                u = unitW * (combinedRadius * inverseStep - wLength);
+            }
+
+            // Half of the change is ours
+            line.point = agent.velocity + u * 0.5f;
+        }
+
+        glm::vec2 result;
+        std::size_t failed = linearProgram2(lines, neighboursCount, agent.maxSpeed, agent.preferredVelocity, false, result);
+        if(failed < neighboursCount) {
+            linearProgram3(lines, neighboursCount, failed, agent.maxSpeed, result);
+        }
+
+        return result;
+    }
+
+    // Best point on line lineIndex which satisfies lines before it and lies within radius, false if there is none
+    static bool linearProgram1(const Line* lines, std::size_t lineIndex, float radius, glm::vec2 optimal,
+                               bool directionOptimal, glm::vec2& result) {
+        const Line& line = lines[lineIndex];
+        float dotProduct = glm::dot(line.point, line.direction);
+        float discriminant = dotProduct * dotProduct + radius * radius - glm::dot(line.point, line.point);
+        if(discriminant < 0.0f) {
+            return false;   // the line misses the speed circle
+        }
+
+        float sqrtDiscriminant = std::sqrt(discriminant);
+        float left = -dotProduct - sqrtDiscriminant;
+        float right = -dotProduct + sqrtDiscriminant;
+
+        for(std::size_t i = 0; i < lineIndex; ++i) {
+            float denominator = det(line.direction, lines[i].direction);
+            float numerator = det(lines[i].direction, line.point - lines[i].point);
+
+            if(std::fabs(denominator) <= EPSILON) {
+                // Parallel lines
+                if(numerator < 0.0f) return false;
+                continue;
+            }
+
+            float t = numerator / denominator;
+            if(denominator >= 0.0f) {
+                right = std::min(right, t);
+            } else {
+                left = std::max(left, t);
+            }
+
+            if(left > right) return false;
+        }
+
+        if(directionOptimal) {
+            result = line.point + line.direction * ((glm::dot(optimal, line.direction) > 0.0f) ? right : left);
+        } else {
+            float t = glm::clamp(glm::dot(line.direction, optimal - line.point), left, right);
+            result = line.point + line.direction * t;
+        }
+
+        return true;
+    }
+
+    // Velocity nearest to optimal (or furthest in its direction) within all lines and radius.
+    // Returns the index of the line which couldn't be satisfied, count on success.
+    static std::size_t linearProgram2(const Line* lines, std::size_t count, float radius, glm::vec2 optimal,
+                                      bool directionOptimal, glm::vec2& result) {
+        if(directionOptimal) {
+            result = optimal * radius;
+        } else if(glm::dot(optimal, optimal) > radius * radius) {
+            result = glm::normalize(optimal) * radius;
+        } else {
+            result = optimal;
+        }
+
+        for(std::size_t i = 0; i < count; ++i) {
+            if(det(lines[i].direction, lines[i].point - result) > 0.0f) {
+                glm::vec2 previous = result;
+                if(!linearProgram1(lines, i, radius, optimal, directionOptimal, result)) {
+                    result = previous;
+                    return i;
+                }
+            }
+        }
+
+        return count;
+    }
+
+    // Infeasible program: the velocity which minimises the largest violation of lines [begin, count)
+    static void linearProgram3(const Line* lines, std::size_t count, std::size_t begin, float radius, glm::vec2& result) {
+        float distance = 0.0f;
+
+        for(std::size_t i = begin; i < count; ++i) {
+            if(det(lines[i].direction, lines[i].point - result) <= distance) {
+                continue;
+            }
+
+            // Lines before i, projected onto line i
+            Line projected[MAX_LINES];
+            std::size_t projectedCount = 0;
+            for(std::size_t j = 0; j < i; ++j) {
+                Line line;
+                float determinant = det(lines[i].direction, lines[j].direction);
+
+                if(std::fabs(determinant) <= EPSILON) {
+                    if(glm::dot(lines[i].direction, lines[j].direction) > 0.0f) continue;    // same direction
+                    line.point = (lines[i].point + lines[j].point) * 0.5f;
+                } else {
+                    line.point = lines[i].point + lines[i].direction *
+                                 (det(lines[j].direction, lines[i].point - lines[j].point) / determinant);
+                }
+
+                line.direction = glm::normalize(lines[j].direction - lines[i].direction);
+                projected[projectedCount++] = line;
+            }
+
+            glm::vec2 previous = result;
+            if(linearProgram2(projected, projectedCount, radius, glm::vec2(-lines[i].direction.y, lines[i].direction.x),
+                              true, result) < projectedCount) {
+                // Can only fail because of rounding, the result of the previous lines is the better one
+                result = previous;
+            }
+
+            distance = det(lines[i].direction, lines[i].point - result);
+        }
+    }
+
+    std::vector<Agent>          m_agents;
+    std::vector<glm::vec2>      m_velocities;
+    SpatialHashGrid             m_grid;     // entity = index to m_agents, cells of neighbourDistance
+};
+
+#endif // ORCA_H_INCLUDED
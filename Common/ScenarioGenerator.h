@@ -0,0 +1,273 @@
+#ifndef SCENARIOGENERATOR_H_INCLUDED
+#define SCENARIOGENERATOR_H_INCLUDED
+
+#include <vector>
+#include <random>
+#include <functional>
+#include <cmath>
+#include <algorithm>
+
+#include "entt.hpp"
+#include "glm/glm.hpp"
+#include "Components/Components.h"
+#include "SteeringManager.h"
+
+/*
+ * Seeded procedural worlds made of the same components TestScene uses, for
+ * stress runs from a hundred to a hundred thousand agents.
+ *
+ * Obstacles are Poisson-disk distributed (no two closer than
+ * obstacleSpacing), walls are what remains of a maze carved on a grid of
+ * mazeCellSize cells after a fraction mazeOpenness of the remaining walls
+ * is knocked down, so corridors have loops. The world wraps around like
+ * the screen does, GameData::screenSize should be set to worldSize.
+ *
+ * Agents are split by the behaviour mix:
+ *   leaders    - no AI, cross the world in a straight line (PhysicsSystem)
+ *   followers  - offset pursuit of a leader, in packs
+ *   chasers    - pursuit of a random agent created before them
+ * Every AI agent avoids obstacles before anything else and wanders a
+ * little after, combined as config.combination says (see SteeringSettings).
+ * Walls aren't avoided, wallAvoidance() would cost more than the rest.
+ *
+ * The same seed and config give the same world.
+ */
+struct ScenarioConfig {
+    unsigned int    seed = 1;
+    std::size_t     agentsCount = 1000;
+    float           areaPerAgent = 6400.0f;     // world side is sqrt(agentsCount * areaPerAgent), at least 640
+    float           obstacleSpacing = 150.0f;   // 0 means no obstacles
+    float           mazeCellSize = 400.0f;      // 0 means no walls
+    float           mazeOpenness = 0.5f;
+
+    // Fractions of agentsCount, normalised; there is at least one leader
+    float           leaders = 0.05f;
+    float           followers = 0.75f;
+    float           chasers = 0.2f;
+
+    SteeringSettings::CombinationMode combination = SteeringSettings::PRIORITISED;
+};
+
+struct ScenarioStats {
+    float           worldSize;
+    std::size_t     leaders;
+    std::size_t     followers;
+    std::size_t     chasers;
+    std::size_t     obstacles;
+    std::size_t     walls;
+};
+
+class ScenarioGenerator {
+public:
+    // Creates an entity with a Transform at position, TestScene passes one which also makes it drawable
+    using EntityFactory = std::function<entt::entity(entt::registry&, glm::vec2)>;
+
+    explicit ScenarioGenerator(const ScenarioConfig& config): m_config(config), m_random(config.seed) { }
+
+    void setEntityFactory(EntityFactory factory) { m_factory = factory; }
+
+    ScenarioStats generate(entt::registry& registry) {
+        ScenarioStats stats{};
+        stats.worldSize = std::max(640.0f, std::sqrt(m_config.agentsCount * m_config.areaPerAgent));
+        m_worldSize = stats.worldSize;
+
+        if(m_config.obstacleSpacing > 0.0f) {
+            for(glm::vec2 position: poissonDisk(m_config.obstacleSpacing)) {
+                entt::entity obstacle = registry.create();
+                registry.assign<Transform>(obstacle, position, glm::vec2(0.0f, 0.0f), 1.0f, 0.0f);
+                registry.assign<Physics>(obstacle, 1.0f, 1.0f, 1.0f, 1.0f, uniform(15.0f, 30.0f));
+                registry.assign<Obstacle>(obstacle, SDL_Color{0, 255, 0, 255});
+                stats.obstacles++;
+            }
+        }
+
+        if(m_config.mazeCellSize > 0.0f) {
+            for(const Line2D& line: maze(m_config.mazeCellSize, m_config.mazeOpenness)) {
+                registry.assign<Wall>(registry.create(), line, SDL_Color{0, 255, 0, 255});
+                stats.walls++;
+            }
+        }
+
+        createAgents(registry, stats);
+
+        return stats;
+    }
+
+private:
+    float uniform(float min, float max) {
+        return std::uniform_real_distribution<float>(min, max)(m_random);
+    }
+
+    std::size_t uniformIndex(std::size_t count) {
+        return std::uniform_int_distribution<std::size_t>(0, count - 1)(m_random);
+    }
+
+    glm::vec2 randomPosition() {
+        return glm::vec2(uniform(0.0f, m_worldSize), uniform(0.0f, m_worldSize));
+    }
+
+    entt::entity createEntity(entt::registry& registry, glm::vec2 position) {
+        if(m_factory) return m_factory(registry, position);
+
+        entt::entity entity = registry.create();
+        registry.assign<Transform>(entity, position, glm::vec2(32.0f, 32.0f), 1.0f, 0.0f);
+        return entity;
+    }
+
+    void createAgents(entt::registry& registry, ScenarioStats& stats) {
+        std::size_t count = m_config.agentsCount;
+        float total = std::max(m_config.leaders + m_config.followers + m_config.chasers, 1e-6f);
+
+        stats.leaders = std::min(count, std::max<std::size_t>(1, std::size_t(count * m_config.leaders / total)));
+        stats.followers = std::min(count - stats.leaders, std::size_t(count * m_config.followers / total + 0.5f));
+        stats.chasers = count - stats.leaders - stats.followers;
+
+        std::vector<entt::entity> leaders, agents;
+        for(std::size_t i = 0; i < count; ++i) {
+            entt::entity agent = createEntity(registry, randomPosition());
+            Physics& physics = registry.assign<Physics>(agent, 150.0f, 1.0f, 200.0f, 100.0f, 20.0f);
+
+            if(i < stats.leaders) {
+                float angle = uniform(0.0f, 360.0f);
+                physics.velocity = orientationToVec(glm::radians(angle)) * uniform(40.0f, 100.0f);
+                registry.get<Transform>(agent).angle = vecToOrientation(physics.velocity);
+                leaders.push_back(agent);
+            } else {
+                bool follower = i < stats.leaders + stats.followers;
+
+                AI& ai = registry.assign<AI>(agent, follower ? leaders[uniformIndex(leaders.size())]
+                                                             : agents[uniformIndex(agents.size())]);
+
+                SteeringSettings& settings = ai.settings;
+                settings = SteeringSettings();
+                settings.mode = m_config.combination;
+                settings.enable(SteeringSettings::OBSTACLE_AVOIDANCE);
+                settings.enable(follower ? SteeringSettings::OFFSET_PURSUIT : SteeringSettings::PURSUIT);
+                settings.enable(SteeringSettings::WANDER, 0.3f);
+
+                registry.assign<WanderState>(agent, entt::to_integral(agent));
+            }
+
+            agents.push_back(agent);
+        }
+    }
+
+    // Bridson's algorithm, the world is not treated as wrapping
+    std::vector<glm::vec2> poissonDisk(float spacing) {
+        const int attempts = 30;
+        float cellSize = spacing / std::sqrt(2.0f);
+        int width = int(std::ceil(m_worldSize / cellSize));
+
+        std::vector<int> grid(width * width, -1);
+        std::vector<glm::vec2> points, active;
+
+        auto cellOf = [&](glm::vec2 point) {
+            return glm::ivec2(std::min(int(point.x / cellSize), width - 1), std::min(int(point.y / cellSize), width - 1));
+        };
+
+        auto addPoint = [&](glm::vec2 point) {
+            glm::ivec2 cell = cellOf(point);
+            grid[cell.y * width + cell.x] = int(points.size());
+            points.push_back(point);
+            active.push_back(point);
+        };
+
+        auto isFree = [&](glm::vec2 point) {
+            glm::ivec2 cell = cellOf(point);
+            for(int y = std::max(cell.y - 2, 0); y <= std::min(cell.y + 2, width - 1); ++y) {
+                for(int x = std::max(cell.x - 2, 0); x <= std::min(cell.x + 2, width - 1); ++x) {
+                    int index = grid[y * width + x];
+                    if(index >= 0 && glm::distance(points[index], point) < spacing) return false;
+                }
+            }
+
+            return true;
+        };
+
+        addPoint(randomPosition());
+        while(!active.empty()) {
+            std::size_t current = uniformIndex(active.size());
+            glm::vec2 origin = active[current];
+
+            bool found = false;
+            for(int i = 0; i < attempts && !found; ++i) {
+                float angle = uniform(0.0f, 6.2831853f);
+                glm::vec2 candidate = origin + glm::vec2(std::cos(angle), std::sin(angle)) * uniform(spacing, 2.0f * spacing);
+
+                if(candidate.x < 0.0f || candidate.y < 0.0f || candidate.x >= m_worldSize || candidate.y >= m_worldSize) continue;
+                if(isFree(candidate)) {
+                    addPoint(candidate);
+                    found = true;
+                }
+            }
+
+            if(!found) {
+                active[current] = active.back();
+                active.pop_back();
+            }
+        }
+
+        return points;
+    }
+
+    // Depth-first maze on a grid of cells, walls between cells only: the world border is open
+    std::vector<Line2D> maze(float cellSize, float openness) {
+        int width = std::max(1, int(m_worldSize / cellSize));
+
+        // Wall on the right (x) and below (y) of every cell, the last row and column have none
+        std::vector<char> right(width * width, 1), below(width * width, 1);
+        std::vector<char> visited(width * width, 0);
+
+        std::vector<int> stack{0};
+        visited[0] = 1;
+        while(!stack.empty()) {
+            int cell = stack.back();
+            int x = cell % width, y = cell / width;
+
+            int neighbours[4], count = 0;
+            if(x > 0 && !visited[cell - 1]) neighbours[count++] = cell - 1;
+            if(x < width - 1 && !visited[cell + 1]) neighbours[count++] = cell + 1;
+            if(y > 0 && !visited[cell - width]) neighbours[count++] = cell - width;
+            if(y < width - 1 && !visited[cell + width]) neighbours[count++] = cell + width;
+
+            if(count == 0) {
+                stack.pop_back();
+                continue;
+            }
+
+            int next = neighbours[uniformIndex(count)];
+            if(next == cell + 1) right[cell] = 0;
+            else if(next == cell - 1) right[next] = 0;
+            else if(next == cell + width) below[cell] = 0;
+            else below[next] = 0;
+
+            visited[next] = 1;
+            stack.push_back(next);
+        }
+
+        std::vector<Line2D> walls;
+        for(int y = 0; y < width; ++y) {
+            for(int x = 0; x < width; ++x) {
+                int cell = y * width + x;
+                glm::vec2 corner = glm::vec2(x + 1, y + 1) * cellSize;
+
+                if(x < width - 1 && right[cell] && uniform(0.0f, 1.0f) >= openness) {
+                    walls.push_back(Line2D{corner - glm::vec2(0.0f, cellSize), corner});
+                }
+
+                if(y < width - 1 && below[cell] && uniform(0.0f, 1.0f) >= openness) {
+                    walls.push_back(Line2D{corner - glm::vec2(cellSize, 0.0f), corner});
+                }
+            }
+        }
+
+        return walls;
+    }
+
+    ScenarioConfig  m_config;
+    std::mt19937    m_random;
+    EntityFactory   m_factory;
+    float           m_worldSize;
+};
+
+#endif // SCENARIOGENERATOR_H_INCLUDED
@@ -0,0 +1,257 @@
+#ifndef SEGMENTBATCH_H_INCLUDED
+#define SEGMENTBATCH_H_INCLUDED
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <glm/glm.hpp>
+
+#include "Common.h"
+
+/*
+ * Segments stored as structure of arrays (start, direction, normal), so one
+ * ray can be tested against 8 (AVX) or 4 (SSE2) segments at once.
+ *
+ * Arrays are padded with SEGMENT_BATCH_PADDING zero segments, hence a kernel
+ * can always load a full register: padding segments have zero direction and
+ * are rejected as parallel to any ray.
+ *
+ * The SIMD kernel and the scalar fallback do the same float operations in the
+ * same order and break ties by the lowest index, so they return identical
+ * hits (as long as the compiler isn't allowed to fuse multiply-adds).
+ */
+
+const std::size_t SEGMENT_BATCH_PADDING = 8;
+
+// Squared cross product of directions below this value means parallel lines
+const float SEGMENT_PARALLEL_EPSILON = 0.001f;
+
+struct SegmentBatch {
+    SegmentBatch() {
+        clear();
+    }
+
+    void clear() {
+        startX.assign(SEGMENT_BATCH_PADDING, 0.0f);
+        startY.assign(SEGMENT_BATCH_PADDING, 0.0f);
+        directionX.assign(SEGMENT_BATCH_PADDING, 0.0f);
+        directionY.assign(SEGMENT_BATCH_PADDING, 0.0f);
+        normalX.assign(SEGMENT_BATCH_PADDING, 0.0f);
+        normalY.assign(SEGMENT_BATCH_PADDING, 0.0f);
+        m_size = 0;
+    }
+
+    void push_back(const Line2D& line, glm::vec2 normal) {
+        resize(m_size + 1);
+        set(m_size - 1, line, normal);
+    }
+
+    void resize(std::size_t size) {
+        m_size = size;
+        startX.resize(size + SEGMENT_BATCH_PADDING, 0.0f);
+        startY.resize(size + SEGMENT_BATCH_PADDING, 0.0f);
+        directionX.resize(size + SEGMENT_BATCH_PADDING, 0.0f);
+        directionY.resize(size + SEGMENT_BATCH_PADDING, 0.0f);
+        normalX.resize(size + SEGMENT_BATCH_PADDING, 0.0f);
+        normalY.resize(size + SEGMENT_BATCH_PADDING, 0.0f);
+    }
+
+    void set(std::size_t index, const Line2D& line, glm::vec2 normal) {
+        startX[index] = line.start.x;
+        startY[index] = line.start.y;
+        directionX[index] = line.end.x - line.start.x;
+        directionY[index] = line.end.y - line.start.y;
+        normalX[index] = normal.x;
+        normalY[index] = normal.y;
+    }
+
+    std::size_t size() const { return m_size; }
+
+    std::vector<float> startX, startY;
+    std::vector<float> directionX, directionY;
+    std::vector<float> normalX, normalY;
+
+private:
+    std::size_t m_size;
+};
+
+struct SegmentHit {
+    float           t;          // ray parameter in [0, 1]
+    float           distance;   // from the ray start
+    glm::vec2       point;
+    glm::vec2       normal;
+    std::size_t     index;      // in the batch
+};
+
+namespace detail {
+    inline void fillSegmentHit(const SegmentBatch& segments, const Line2D& ray, float t, std::size_t index, SegmentHit& hit) {
+        glm::vec2 direction = ray.end - ray.start;
+
+        hit.t = t;
+        hit.distance = t * glm::length(direction);
+        hit.point = ray.start + direction * t;
+        hit.normal = glm::vec2(segments.normalX[index], segments.normalY[index]);
+        hit.index = index;
+    }
+}
+
+// Ray parameter t in [0, 1] where ray crosses the segment start + [0, 1] * direction, false if it doesn't.
+// The kernels below do the same float operations.
+inline bool rayCastSegment(float startX, float startY, float directionX, float directionY, const Line2D& ray, float& t) {
+    const float dx = ray.end.x - ray.start.x, dy = ray.end.y - ray.start.y;
+    float wx = ray.start.x - startX, wy = ray.start.y - startY;
+
+    float denom = directionX * dy - directionY * dx;
+    t = (wx * directionY - wy * directionX) / denom;
+    float u = (wx * dy - wy * dx) / denom;
+
+    return denom * denom >= SEGMENT_PARALLEL_EPSILON && t >= 0.0f && t <= 1.0f && u >= 0.0f && u <= 1.0f;
+}
+
+// Closest hit of the segment ray.start -> ray.end against segments [first, last)
+inline bool rayCastSegmentsScalar(const SegmentBatch& segments, std::size_t first, std::size_t last,
+                                  const Line2D& ray, SegmentHit& hit) {
+    float bestT = std::numeric_limits<float>::infinity();
+    std::size_t bestIndex = last;
+
+    for(auto i = first; i < last; ++i) {
+        float t;
+        if(rayCastSegment(segments.startX[i], segments.startY[i], segments.directionX[i], segments.directionY[i], ray, t) &&
+           t < bestT) {
+            bestT = t;
+            bestIndex = i;
+        }
+    }
+
+    if(bestIndex == last) return false;
+
+    detail::fillSegmentHit(segments, ray, bestT, bestIndex, hit);
+    return true;
+}
+
+#if defined(__AVX__) || defined(__SSE2__)
+
+#if defined(__AVX__)
+    #define SEGMENT_BATCH_WIDTH 8
+    using SegmentFloats = __m256;
+    #define SB_SET1(x)          _mm256_set1_ps(x)
+    #define SB_LOAD(p)          _mm256_loadu_ps(p)
+    #define SB_ADD(a, b)        _mm256_add_ps(a, b)
+    #define SB_SUB(a, b)        _mm256_sub_ps(a, b)
+    #define SB_MUL(a, b)        _mm256_mul_ps(a, b)
+    #define SB_DIV(a, b)        _mm256_div_ps(a, b)
+    #define SB_AND(a, b)        _mm256_and_ps(a, b)
+    #define SB_GE(a, b)         _mm256_cmp_ps(a, b, _CMP_GE_OQ)
+    #define SB_LE(a, b)         _mm256_cmp_ps(a, b, _CMP_LE_OQ)
+    #define SB_LT(a, b)         _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+    #define SB_BLEND(a, b, m)   _mm256_blendv_ps(a, b, m)
+    #define SB_STORE(p, a)      _mm256_storeu_ps(p, a)
+#else
+    #define SEGMENT_BATCH_WIDTH 4
+    using SegmentFloats = __m128;
+    #define SB_SET1(x)          _mm_set1_ps(x)
+    #define SB_LOAD(p)          _mm_loadu_ps(p)
+    #define SB_ADD(a, b)        _mm_add_ps(a, b)
+    #define SB_SUB(a, b)        _mm_sub_ps(a, b)
+    #define SB_MUL(a, b)        _mm_mul_ps(a, b)
+    #define SB_DIV(a, b)        _mm_div_ps(a, b)
+    #define SB_AND(a, b)        _mm_and_ps(a, b)
+    #define SB_GE(a, b)         _mm_cmpge_ps(a, b)
+    #define SB_LE(a, b)         _mm_cmple_ps(a, b)
+    #define SB_LT(a, b)         _mm_cmplt_ps(a, b)
+    #define SB_BLEND(a, b, m)   _mm_or_ps(_mm_andnot_ps(m, a), _mm_and_ps(m, b))
+    #define SB_STORE(p, a)      _mm_storeu_ps(p, a)
+#endif
+
+// Same as rayCastSegmentsScalar, SEGMENT_BATCH_WIDTH segments per iteration
+inline bool rayCastSegments(const SegmentBatch& segments, std::size_t first, std::size_t last,
+                            const Line2D& ray, SegmentHit& hit) {
+    const int width = SEGMENT_BATCH_WIDTH;
+
+    const SegmentFloats ox = SB_SET1(ray.start.x), oy = SB_SET1(ray.start.y);
+    const SegmentFloats dx = SB_SET1(ray.end.x - ray.start.x), dy = SB_SET1(ray.end.y - ray.start.y);
+    const SegmentFloats zero = SB_SET1(0.0f), one = SB_SET1(1.0f);
+    const SegmentFloats epsilon = SB_SET1(SEGMENT_PARALLEL_EPSILON);
+
+    // Lane indices are kept as floats: exact up to 2^24 segments and blendable with the same mask
+    float laneOffsets[SEGMENT_BATCH_WIDTH];
+    for(int lane = 0; lane < width; ++lane) laneOffsets[lane] = float(lane);
+    const SegmentFloats lanes = SB_LOAD(laneOffsets);
+    const SegmentFloats lastIndex = SB_SET1(float(last - first));
+
+    SegmentFloats bestT = SB_SET1(std::numeric_limits<float>::infinity());
+    SegmentFloats bestIndex = SB_SET1(-1.0f);
+
+    for(auto i = first; i < last; i += width) {
+        SegmentFloats ex = SB_LOAD(&segments.directionX[i]), ey = SB_LOAD(&segments.directionY[i]);
+        SegmentFloats wx = SB_SUB(ox, SB_LOAD(&segments.startX[i]));
+        SegmentFloats wy = SB_SUB(oy, SB_LOAD(&segments.startY[i]));
+
+        SegmentFloats denom = SB_SUB(SB_MUL(ex, dy), SB_MUL(ey, dx));
+        SegmentFloats t = SB_DIV(SB_SUB(SB_MUL(wx, ey), SB_MUL(wy, ex)), denom);
+        SegmentFloats u = SB_DIV(SB_SUB(SB_MUL(wx, dy), SB_MUL(wy, dx)), denom);
+
+        SegmentFloats index = SB_ADD(lanes, SB_SET1(float(i - first)));
+
+        SegmentFloats valid = SB_GE(SB_MUL(denom, denom), epsilon);
+        valid = SB_AND(valid, SB_AND(SB_GE(t, zero), SB_LE(t, one)));
+        valid = SB_AND(valid, SB_AND(SB_GE(u, zero), SB_LE(u, one)));
+        valid = SB_AND(valid, SB_AND(SB_LT(t, bestT), SB_LT(index, lastIndex)));
+
+        bestT = SB_BLEND(bestT, t, valid);
+        bestIndex = SB_BLEND(bestIndex, index, valid);
+    }
+
+    float laneT[SEGMENT_BATCH_WIDTH], laneIndex[SEGMENT_BATCH_WIDTH];
+    SB_STORE(laneT, bestT);
+    SB_STORE(laneIndex, bestIndex);
+
+    // Every lane holds its lowest index among its minimal t, pick the same one the scalar loop would
+    int bestLane = -1;
+    for(int lane = 0; lane < width; ++lane) {
+        if(laneIndex[lane] < 0.0f) continue;
+
+        if(bestLane < 0 || laneT[lane] < laneT[bestLane] ||
+           (laneT[lane] == laneT[bestLane] && laneIndex[lane] < laneIndex[bestLane])) {
+            bestLane = lane;
+        }
+    }
+
+    if(bestLane < 0) return false;
+
+    detail::fillSegmentHit(segments, ray, laneT[bestLane], first + std::size_t(laneIndex[bestLane]), hit);
+    return true;
+}
+
+#undef SB_SET1
+#undef SB_LOAD
+#undef SB_ADD
+#undef SB_SUB
+#undef SB_MUL
+#undef SB_DIV
+#undef SB_AND
+#undef SB_GE
+#undef SB_LE
+#undef SB_LT
+#undef SB_BLEND
+#undef SB_STORE
+
+#else
+
+#define SEGMENT_BATCH_WIDTH 1
+
+inline bool rayCastSegments(const SegmentBatch& segments, std::size_t first, std::size_t last,
+                            const Line2D& ray, SegmentHit& hit) {
+    return rayCastSegmentsScalar(segments, first, last, ray, hit);
+}
+
+#endif
+
+#endif // SEGMENTBATCH_H_INCLUDED
@@ -0,0 +1,212 @@
+#ifndef SPATIALHASHGRID_H_INCLUDED
+#define SPATIALHASHGRID_H_INCLUDED
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include "entt.hpp"
+
+/*
+ * Uniform grid over circles (position + radius) hashed into a fixed table of
+ * buckets, so the grid doesn't care about world bounds.
+ *
+ * Usage per tick: clear(), insert() every object, build(). build() sorts all
+ * items by bucket (counting sort), so a query only touches contiguous memory.
+ *
+ * Items are bucketed by the cell of their center. A query rectangle is
+ * therefore a rectangle of centers: callers who want overlapping circles have
+ * to expand their rectangle by getMaxRadius() themselves.
+ *
+ * Each item is reported at most once per query: we remember item's cell and
+ * skip items that only share the bucket because of a hash collision.
+ */
+class SpatialHashGrid {
+public:
+    struct Item {
+        entt::entity    entity;
+        glm::vec2       position;
+        float           radius;
+        int             cellX;
+        int             cellY;
+    };
+
+    // If cellSize is zero, build() picks it from the biggest inserted radius
+    explicit SpatialHashGrid(float cellSize = 0.0f): m_cellSize(cellSize),
+                                                     m_invCellSize(0.0f),
+                                                     m_autoCellSize(cellSize <= 0.0f),
+                                                     m_maxRadius(0.0f),
+                                                     m_bucketMask(0) { }
+
+    void clear() {
+        m_items.clear();
+        m_maxRadius = 0.0f;
+    }
+
+    void insert(entt::entity entity, glm::vec2 position, float radius) {
+        m_items.push_back(Item{entity, position, radius, 0, 0});
+        m_maxRadius = std::max(m_maxRadius, radius);
+    }
+
+    void build() {
+        if(m_autoCellSize) {
+            m_cellSize = std::max(2.0f * m_maxRadius, MIN_CELL_SIZE);
+        }
+        m_invCellSize = 1.0f / m_cellSize;
+
+        std::size_t bucketsCount = 64;
+        while(bucketsCount < m_items.size() * 2) bucketsCount <<= 1;
+        m_bucketMask = bucketsCount - 1;
+
+        m_bucketStart.assign(bucketsCount + 1, 0);
+        for(auto& item: m_items) {
+            item.cellX = cellCoord(item.position.x);
+            item.cellY = cellCoord(item.position.y);
+            m_bucketStart[hash(item.cellX, item.cellY) + 1]++;
+        }
+
+        for(std::size_t i = 1; i <= bucketsCount; ++i) {
+            m_bucketStart[i] += m_bucketStart[i - 1];
+        }
+
+        m_sortedItems.resize(m_items.size());
+        m_fill.assign(m_bucketStart.begin(), m_bucketStart.end() - 1);
+        for(const auto& item: m_items) {
+            m_sortedItems[m_fill[hash(item.cellX, item.cellY)]++] = item;
+        }
+    }
+
+    // Calls callback(const Item&) for each item whose center lies in cells covered by [min, max]
+    template<typename Callback>
+    void queryRect(glm::vec2 min, glm::vec2 max, Callback callback) const {
+        if(m_sortedItems.empty()) return;
+
+        int minX = cellCoord(min.x), maxX = cellCoord(max.x);
+        int minY = cellCoord(min.y), maxY = cellCoord(max.y);
+
+        // Huge rectangle: it's cheaper to walk everything once
+        if(std::int64_t(maxX - minX + 1) * std::int64_t(maxY - minY + 1) >= std::int64_t(m_bucketMask + 1)) {
+            for(const auto& item: m_sortedItems) {
+                if(item.cellX >= minX && item.cellX <= maxX &&
+                   item.cellY >= minY && item.cellY <= maxY) {
+                    callback(item);
+                }
+            }
+
+            return;
+        }
+
+        for(int y = minY; y <= maxY; ++y) {
+            for(int x = minX; x <= maxX; ++x) {
+                std::size_t bucket = hash(x, y);
+                for(auto i = m_bucketStart[bucket]; i < m_bucketStart[bucket + 1]; ++i) {
+                    const Item& item = m_sortedItems[i];
+                    if(item.cellX == x && item.cellY == y) {
+                        callback(item);
+                    }
+                }
+            }
+        }
+    }
+
+    // Calls callback(const Item&) for each item whose circle intersects the given circle
+    template<typename Callback>
+    void queryRadius(glm::vec2 center, float radius, Callback callback) const {
+        float reach = radius + m_maxRadius;
+        queryRect(center - glm::vec2(reach), center + glm::vec2(reach), [&](const Item& item) {
+            glm::vec2 d = item.position - center;
+            float r = radius + item.radius;
+            if(glm::dot(d, d) <= r * r) {
+                callback(item);
+            }
+        });
+    }
+
+    // Visits items in rings of cells around center, nearest rings first. Before every ring
+    // shouldContinue(lowerBound) is asked whether to go on, lowerBound is the minimal distance
+    // from center to any item center in this and further rings. Centers further than maxDistance are skipped.
+    template<typename Callback, typename Continue>
+    void searchOutward(glm::vec2 center, float maxDistance, Callback callback, Continue shouldContinue) const {
+        if(m_sortedItems.empty()) return;
+
+        int centerX = cellCoord(center.x), centerY = cellCoord(center.y);
+        int maxRing = int(std::ceil(maxDistance * m_invCellSize)) + 1;
+
+        // Too many cells compared to items: just check everything
+        if(std::int64_t(2 * maxRing + 1) * std::int64_t(2 * maxRing + 1) > std::int64_t(m_sortedItems.size()) * 4) {
+            for(const auto& item: m_sortedItems) {
+                if(glm::distance(center, item.position) <= maxDistance) {
+                    callback(item);
+                }
+            }
+
+            return;
+        }
+
+        auto visitCell = [&](int x, int y) {
+            std::size_t bucket = hash(x, y);
+            for(auto i = m_bucketStart[bucket]; i < m_bucketStart[bucket + 1]; ++i) {
+                const Item& item = m_sortedItems[i];
+                if(item.cellX == x && item.cellY == y && glm::distance(center, item.position) <= maxDistance) {
+                    callback(item);
+                }
+            }
+        };
+
+        for(int ring = 0; ring <= maxRing; ++ring) {
+            if(!shouldContinue(std::max(0, ring - 1) * m_cellSize)) return;
+
+            if(ring == 0) {
+                visitCell(centerX, centerY);
+                continue;
+            }
+
+            for(int x = centerX - ring; x <= centerX + ring; ++x) {
+                visitCell(x, centerY - ring);
+                visitCell(x, centerY + ring);
+            }
+
+            for(int y = centerY - ring + 1; y <= centerY + ring - 1; ++y) {
+                visitCell(centerX - ring, y);
+                visitCell(centerX + ring, y);
+            }
+        }
+    }
+
+    float getCellSize() const { return m_cellSize; }
+    float getMaxRadius() const { return m_maxRadius; }
+    std::size_t size() const { return m_sortedItems.size(); }
+
+    const std::vector<Item>& getItems() const { return m_sortedItems; }
+
+private:
+    static constexpr float MIN_CELL_SIZE = 16.0f;
+
+    int cellCoord(float value) const {
+        return int(std::floor(value * m_invCellSize));
+    }
+
+    std::size_t hash(int x, int y) const {
+        return (std::uint32_t(x) * 73856093u ^ std::uint32_t(y) * 19349663u) & m_bucketMask;
+    }
+
+    float                       m_cellSize;
+    float                       m_invCellSize;
+    bool                        m_autoCellSize;
+    float                       m_maxRadius;
+
+    std::vector<Item>           m_items;
+    std::vector<Item>           m_sortedItems;
+    std::vector<std::size_t>    m_bucketStart;
+    std::vector<std::size_t>    m_fill;
+    std::size_t                 m_bucketMask;
+};
+
+// Registry context: all Obstacle circles, rebuilt every tick by ObstacleGridSystem
+struct ObstacleGrid: public SpatialHashGrid {
+    ObstacleGrid(): SpatialHashGrid(0.0f) { }
+};
+
+#endif // SPATIALHASHGRID_H_INCLUDED
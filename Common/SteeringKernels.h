@@ -0,0 +1,284 @@
+#ifndef STEERINGKERNELS_H_INCLUDED
+#define STEERINGKERNELS_H_INCLUDED
+
+#include <vector>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "entt.hpp"
+#include "glm/glm.hpp"
+#include "Common.h"
+#include "Components/Components.h"
+
+/*
+ * seek, flee, arrive, pursuit and evade written once for a number type T:
+ * float for SteeringManager and Float4, four SSE lanes, for the batch
+ * versions. Those run over AgentBatch, SoA arrays gathered from the registry
+ * (AISteeringSystem does it per archetype group whose pipeline has only these
+ * stages, see SteeringPipeline.h), four agents at a time and the remainder
+ * with float, so both paths compute exactly the same thing. Branches are select()s and every
+ * division is done before the select.
+ *
+ * The lanes are explicit: GCC 12 vectorises the plain float loops only with
+ * -O3 -fno-math-errno -fno-trapping-math, which the project doesn't use.
+ * Without SSE2 the batch versions run with float only. pursuit needs
+ * headings, it takes cos/sin of the angles per agent and stays scalar.
+ *
+ * The glm::vec2 overloads keep SteeringManager's quirks, e.g. pursuit takes
+ * the heading from Transform::angle without converting it to radians.
+ */
+namespace SteeringKernels {
+    const float MINIMAL_LENGTH = 0.01f;     // same as MINIMAL_SPEED
+    const float PANIC_DISTANCE = 300.0f;
+
+    inline float sqrt(float value) { return std::sqrt(value); }
+    inline float select(bool condition, float a, float b) { return condition ? a : b; }
+
+#ifdef __SSE2__
+    struct Float4 {
+        Float4() { }
+        Float4(float value): m(_mm_set1_ps(value)) { }
+        explicit Float4(__m128 value): m(value) { }
+
+        __m128 m;
+    };
+
+    inline Float4 operator+(Float4 a, Float4 b) { return Float4(_mm_add_ps(a.m, b.m)); }
+    inline Float4 operator-(Float4 a, Float4 b) { return Float4(_mm_sub_ps(a.m, b.m)); }
+    inline Float4 operator*(Float4 a, Float4 b) { return Float4(_mm_mul_ps(a.m, b.m)); }
+    inline Float4 operator/(Float4 a, Float4 b) { return Float4(_mm_div_ps(a.m, b.m)); }
+    inline Float4 operator>(Float4 a, Float4 b) { return Float4(_mm_cmpgt_ps(a.m, b.m)); }     // all bits set or clear per lane
+
+    inline Float4 sqrt(Float4 value) { return Float4(_mm_sqrt_ps(value.m)); }
+    inline Float4 select(Float4 mask, Float4 a, Float4 b) {
+        return Float4(_mm_or_ps(_mm_and_ps(mask.m, a.m), _mm_andnot_ps(mask.m, b.m)));
+    }
+#endif
+
+    template<typename T>
+    struct Vector {
+        T x, y;
+    };
+
+    template<typename T> Vector<T> operator+(Vector<T> a, Vector<T> b) { return Vector<T>{a.x + b.x, a.y + b.y}; }
+    template<typename T> Vector<T> operator-(Vector<T> a, Vector<T> b) { return Vector<T>{a.x - b.x, a.y - b.y}; }
+    template<typename T> Vector<T> operator*(Vector<T> a, T b) { return Vector<T>{a.x * b, a.y * b}; }
+    template<typename T> Vector<T> operator/(Vector<T> a, T b) { return Vector<T>{a.x / b, a.y / b}; }
+    template<typename T> T dot(Vector<T> a, Vector<T> b) { return a.x * b.x + a.y * b.y; }
+    template<typename T> T length(Vector<T> a) { return sqrt(dot(a, a)); }
+
+    template<typename T>
+    Vector<T> seek(Vector<T> position, Vector<T> velocity, T maxSpeed, Vector<T> target) {
+        Vector<T> direction = target - position;
+        T distance = length(direction);
+        T scale = maxSpeed / distance;
+
+        return direction * select(distance > T(MINIMAL_LENGTH), scale, T(0.0f)) - velocity;
+    }
+
+    template<typename T>
+    Vector<T> flee(Vector<T> position, Vector<T> velocity, T maxSpeed, Vector<T> target) {
+        Vector<T> direction = position - target;
+        T distance = length(direction);
+
+        Vector<T> force = direction * (maxSpeed / distance) - velocity;
+        return force * select(distance > T(PANIC_DISTANCE), T(0.0f), T(1.0f));
+    }
+
+    // deceleration is SteeringManager::Deceleration. The desired speed is distance / (0.3 * deceleration)
+    // along direction / distance, the distance cancels out (and can't divide by zero on the target).
+    template<typename T>
+    Vector<T> arrive(Vector<T> position, Vector<T> velocity, Vector<T> target, int deceleration) {
+        Vector<T> direction = target - position;
+        return direction * T(1.0f / (0.3f * deceleration)) - velocity;
+    }
+
+    template<typename T>
+    Vector<T> evade(Vector<T> position, Vector<T> velocity, T maxSpeed, Vector<T> targetPosition, Vector<T> targetVelocity) {
+        T distance = length(targetPosition - position);
+        T totalSpeed = length(targetVelocity) + length(velocity);
+        T predictTime = distance / totalSpeed;
+
+        predictTime = select(totalSpeed > T(MINIMAL_LENGTH), predictTime, T(0.0f));
+        return flee(position, velocity, maxSpeed, targetPosition + targetVelocity * predictTime);
+    }
+
+    inline Vector<float> pursuit(Vector<float> position, Vector<float> velocity, Vector<float> heading, float maxSpeed,
+                                 Vector<float> targetPosition, Vector<float> targetVelocity, Vector<float> targetHeading) {
+        Vector<float> direction = targetPosition - position;
+        float distance = length(direction);
+
+        // Target ahead and heading the same way (less than 18 degrees apart): seek it directly
+        float relativeHeading = dot(heading, targetHeading);
+        float relativeMovingDirection = (distance > MINIMAL_LENGTH) ? dot(heading, direction) / distance : 0.0f;
+        if(relativeHeading > 0.95f && relativeMovingDirection > 0.0f) {
+            return seek(position, velocity, maxSpeed, targetPosition);
+        }
+
+        float totalSpeed = length(velocity) + length(targetVelocity);
+        float predictTime = (totalSpeed > MINIMAL_LENGTH) ? distance / totalSpeed : 0.0f;
+
+        return seek(position, velocity, maxSpeed, targetPosition + targetVelocity * predictTime);
+    }
+
+    inline Vector<float> toVector(glm::vec2 vector) { return Vector<float>{vector.x, vector.y}; }
+    inline glm::vec2 toGlm(Vector<float> vector) { return glm::vec2(vector.x, vector.y); }
+
+    inline glm::vec2 seek(glm::vec2 position, glm::vec2 velocity, float maxSpeed, glm::vec2 target) {
+        return toGlm(seek(toVector(position), toVector(velocity), maxSpeed, toVector(target)));
+    }
+
+    inline glm::vec2 flee(glm::vec2 position, glm::vec2 velocity, float maxSpeed, glm::vec2 target) {
+        return toGlm(flee(toVector(position), toVector(velocity), maxSpeed, toVector(target)));
+    }
+
+    inline glm::vec2 arrive(glm::vec2 position, glm::vec2 velocity, glm::vec2 target, int deceleration) {
+        return toGlm(arrive(toVector(position), toVector(velocity), toVector(target), deceleration));
+    }
+
+    inline glm::vec2 pursuit(glm::vec2 position, glm::vec2 velocity, glm::vec2 heading, float maxSpeed,
+                             glm::vec2 targetPosition, glm::vec2 targetVelocity, glm::vec2 targetHeading) {
+        return toGlm(pursuit(toVector(position), toVector(velocity), toVector(heading), maxSpeed,
+                             toVector(targetPosition), toVector(targetVelocity), toVector(targetHeading)));
+    }
+
+    inline glm::vec2 evade(glm::vec2 position, glm::vec2 velocity, float maxSpeed,
+                           glm::vec2 targetPosition, glm::vec2 targetVelocity) {
+        return toGlm(evade(toVector(position), toVector(velocity), maxSpeed, toVector(targetPosition), toVector(targetVelocity)));
+    }
+
+    // Agents and their targets (Transform + Physics) copied out of the registry, forces are written to forceX/Y
+    struct AgentBatch {
+        void resize(std::size_t count) {
+            for(auto array: {&positionX, &positionY, &velocityX, &velocityY, &angle, &maxSpeed, &maxForce,
+                             &targetPositionX, &targetPositionY, &targetVelocityX, &targetVelocityY,
+                             &targetAngle, &forceX, &forceY}) {
+                array->resize(count);
+            }
+        }
+
+        std::size_t size() const { return positionX.size(); }
+
+        glm::vec2 getForce(std::size_t i) const { return glm::vec2(forceX[i], forceY[i]); }
+
+        std::vector<float> positionX, positionY;
+        std::vector<float> velocityX, velocityY;
+        std::vector<float> angle;               // Transform::angle
+        std::vector<float> maxSpeed;
+        std::vector<float> maxForce;
+
+        std::vector<float> targetPositionX, targetPositionY;
+        std::vector<float> targetVelocityX, targetVelocityY;
+        std::vector<float> targetAngle;
+
+        std::vector<float> forceX, forceY;
+    };
+
+    // targets[i] is the target of agents[i], both need Transform and Physics
+    inline void gather(entt::registry& registry, Span<const entt::entity> agents, Span<const entt::entity> targets,
+                       AgentBatch& batch) {
+        auto view = registry.view<Transform, Physics>();
+        batch.resize(agents.size());
+
+        for(std::size_t i = 0; i < agents.size(); ++i) {
+            const Transform& transform = view.get<Transform>(agents[i]);
+            const Physics& physics = view.get<Physics>(agents[i]);
+            batch.positionX[i] = transform.position.x;
+            batch.positionY[i] = transform.position.y;
+            batch.velocityX[i] = physics.velocity.x;
+            batch.velocityY[i] = physics.velocity.y;
+            batch.angle[i] = transform.angle;
+            batch.maxSpeed[i] = physics.maxSpeed;
+            batch.maxForce[i] = physics.maxForce;
+
+            const Transform& targetTransform = view.get<Transform>(targets[i]);
+            const Physics& targetPhysics = view.get<Physics>(targets[i]);
+            batch.targetPositionX[i] = targetTransform.position.x;
+            batch.targetPositionY[i] = targetTransform.position.y;
+            batch.targetVelocityX[i] = targetPhysics.velocity.x;
+            batch.targetVelocityY[i] = targetPhysics.velocity.y;
+            batch.targetAngle[i] = targetTransform.angle;
+        }
+    }
+
+    inline float load(float, const float* source) { return *source; }
+    inline void store(float value, float* destination) { *destination = value; }
+    inline float horizontalSum(float value) { return value; }
+#ifdef __SSE2__
+    inline Float4 load(Float4, const float* source) { return Float4(_mm_loadu_ps(source)); }
+    inline void store(Float4 value, float* destination) { _mm_storeu_ps(destination, value.m); }
+
+    // Sum of the four lanes
+    inline float horizontalSum(Float4 value) {
+        __m128 pairs = _mm_add_ps(value.m, _mm_movehl_ps(value.m, value.m));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+#endif
+
+    // forces = kernel(position, velocity, maxSpeed, targetPosition, targetVelocity), four agents at a time then one by one
+    template<typename Kernel>
+    void forEachAgent(AgentBatch& batch, Kernel kernel) {
+        auto run = [&](auto lanes, std::size_t i) {
+            using T = decltype(lanes);
+            auto get = [i](const std::vector<float>& array) { return load(T(), array.data() + i); };
+
+            Vector<T> force = kernel(Vector<T>{get(batch.positionX), get(batch.positionY)},
+                                     Vector<T>{get(batch.velocityX), get(batch.velocityY)}, get(batch.maxSpeed),
+                                     Vector<T>{get(batch.targetPositionX), get(batch.targetPositionY)},
+                                     Vector<T>{get(batch.targetVelocityX), get(batch.targetVelocityY)});
+
+            store(force.x, batch.forceX.data() + i);
+            store(force.y, batch.forceY.data() + i);
+        };
+
+        std::size_t i = 0;
+#ifdef __SSE2__
+        for(; i + 4 <= batch.size(); i += 4) run(Float4(), i);
+#endif
+        for(; i < batch.size(); ++i) run(0.0f, i);
+    }
+
+    inline void seek(AgentBatch& batch) {
+        forEachAgent(batch, [](auto position, auto velocity, auto maxSpeed, auto targetPosition, auto) {
+            return seek(position, velocity, maxSpeed, targetPosition);
+        });
+    }
+
+    inline void flee(AgentBatch& batch) {
+        forEachAgent(batch, [](auto position, auto velocity, auto maxSpeed, auto targetPosition, auto) {
+            return flee(position, velocity, maxSpeed, targetPosition);
+        });
+    }
+
+    inline void arrive(AgentBatch& batch, int deceleration) {
+        forEachAgent(batch, [deceleration](auto position, auto velocity, auto, auto targetPosition, auto) {
+            return arrive(position, velocity, targetPosition, deceleration);
+        });
+    }
+
+    inline void evade(AgentBatch& batch) {
+        forEachAgent(batch, [](auto position, auto velocity, auto maxSpeed, auto targetPosition, auto targetVelocity) {
+            return evade(position, velocity, maxSpeed, targetPosition, targetVelocity);
+        });
+    }
+
+    inline void pursuit(AgentBatch& batch) {
+        for(std::size_t i = 0; i < batch.size(); ++i) {
+            Vector<float> force = pursuit(Vector<float>{batch.positionX[i], batch.positionY[i]},
+                                          Vector<float>{batch.velocityX[i], batch.velocityY[i]},
+                                          Vector<float>{std::cos(batch.angle[i]), std::sin(batch.angle[i])}, batch.maxSpeed[i],
+                                          Vector<float>{batch.targetPositionX[i], batch.targetPositionY[i]},
+                                          Vector<float>{batch.targetVelocityX[i], batch.targetVelocityY[i]},
+                                          Vector<float>{std::cos(batch.targetAngle[i]), std::sin(batch.targetAngle[i])});
+            batch.forceX[i] = force.x;
+            batch.forceY[i] = force.y;
+        }
+    }
+}
+
+namespace sk = SteeringKernels;
+
+#endif // STEERINGKERNELS_H_INCLUDED
@@ -11,16 +11,72 @@ glm::vec2 safeNormalize(glm::vec2 vector);
 glm::vec2 orientationToVec(float angle);
 glm::vec2 wrapVector(glm::vec2 vector, float maxLength);
 
+// Adds as much of force to totalForce as fits in maxForce, false if nothing fitted
+bool accumulateForce(glm::vec2& totalForce, glm::vec2 force, float maxForce);
+
 const float MINIMAL_SPEED = 0.01f;
 
+//Distance between obstacle's border and a hiding spot behind it
+const float HIDING_SPOT_OFFSET = 30.0f;
+
+struct SteeringContext;
+
+/*
+ * Which behaviours SteeringManager::calculate() combines and how, per agent.
+ * Behaviours are declared in priority order, the most important first.
+ *
+ * WEIGHTED_SUM  - every enabled behaviour is evaluated, the weighted sum is truncated to Physics::maxForce.
+ * PRIORITISED   - weighted forces are added in priority order while there is budget left (truncated
+ *                 running sum up to Physics::maxForce); behaviours after the budget is spent are not
+ *                 evaluated at all, so put the expensive ones (hide, wander) last.
+ */
+struct SteeringSettings {
+    enum Behaviour {
+        WALL_AVOIDANCE, OBSTACLE_AVOIDANCE, EVADE, FLEE, SEEK, ARRIVE, PURSUIT, OFFSET_PURSUIT,
+        INTERPOSE, FOLLOW_PATH, HIDE, WANDER, BEHAVIOURS_COUNT
+    };
+
+    enum CombinationMode { WEIGHTED_SUM, PRIORITISED };
+
+    void enable(Behaviour behaviour, float weight = 1.0f) {
+        flags |= 1u << behaviour;
+        weights[behaviour] = weight;
+    }
+
+    void disable(Behaviour behaviour) { flags &= ~(1u << behaviour); }
+    bool isEnabled(Behaviour behaviour) const { return flags & (1u << behaviour); }
+
+    // Behaviours which read SteeringManager::target's components
+    static bool followsTarget(Behaviour behaviour) {
+        return behaviour == EVADE || behaviour == PURSUIT || behaviour == OFFSET_PURSUIT ||
+               behaviour == INTERPOSE || behaviour == HIDE;
+    }
+
+    unsigned int    flags = 0;
+    float           weights[BEHAVIOURS_COUNT] = {};
+    CombinationMode mode = WEIGHTED_SUM;
+
+    // Parameters: seek, flee and arrive go to targetPosition; pursuit, evade, hide and offset pursuit
+    // follow SteeringManager::target; interpose stands between target and secondTarget
+    glm::vec2       targetPosition = glm::vec2(0.0f, 0.0f);
+    entt::entity    secondTarget = entt::null;
+    glm::vec2       offset = glm::vec2(-48.0f, -48.0f);
+    int             deceleration = 2;       // SteeringManager::Deceleration
+};
+
+/*
+ * Behaviours of one agent. The state lives in components (AI: target and
+ * settings, WanderState, WaypointsPath), SteeringManager only points at the
+ * registry and the agent: make one on the stack where it's needed.
+ */
 class SteeringManager {
 public:
     enum Deceleration { FAST = 1, MEDIUM, SLOW };
 
-    entt::entity target;
-
     SteeringManager(entt::registry* registry, entt::entity owner);
 
+    // Force of the behaviours enabled in the AI component, combined as its settings.mode says,
+    // no longer than Physics::maxForce
     glm::vec2 calculate();
 
     //Strategy pattern? i.e for each behavior its own class
@@ -31,6 +87,7 @@ public:
     glm::vec2 pursuit(entt::entity target);
     glm::vec2 evade(entt::entity target);
 
+    // Needs WanderState, zero without it
     glm::vec2 wander();
 
     glm::vec2 obstacleAvoiding();
@@ -41,22 +98,22 @@ public:
     glm::vec2 interpose(entt::entity targetA, entt::entity targetB);
     glm::vec2 hide(entt::entity target);
 
+    // Needs WaypointsPath, zero without it
     glm::vec2 followPath();
 
     glm::vec2 offsetPursuit(entt::entity target, glm::vec2 offset);
 
-    void setPath(const WaypointsPath& path);
+    // Obstacle which obstacleAvoiding2() reacted to during the last calculate(), entt::null if none.
+    // calculate() doesn't touch other entities, the caller marks the obstacle instead.
+    entt::entity getAvoidedObstacle() const { return m_avoidedObstacle; }
 
 private:
-    glm::vec2 findHidingSpot(glm::vec2 obstaclePosition,
-                             float obstacleRadius,
-                             glm::vec2 targetPosition);
+    glm::vec2 evaluate(SteeringSettings::Behaviour behaviour, const SteeringSettings& settings, SteeringContext& context);
 
     entt::registry* m_registry;
-    entt::entity m_owner;
+    entt::entity    m_owner;
 
-    glm::vec2       m_wanderLastOrientation;
-    WaypointsPath   m_path;
+    entt::entity    m_avoidedObstacle;
 };
 
 
@@ -0,0 +1,256 @@
+#ifndef STEERINGPIPELINE_H_INCLUDED
+#define STEERINGPIPELINE_H_INCLUDED
+
+#include <ratio>
+#include <vector>
+#include <type_traits>
+
+#include "entt.hpp"
+#include "glm/glm.hpp"
+#include "Components/Components.h"
+#include "SteeringManager.h"
+#include "SteeringKernels.h"
+
+/*
+ * Steering combinations declared as types instead of SteeringManager objects:
+ *
+ *     using Follower = sp::WeightedSum<sp::Weighted<sp::ObstacleAvoidance, std::ratio<7, 10>>,
+ *                                      sp::Weighted<sp::OffsetPursuit<-48, -48>, std::ratio<3, 10>>>;
+ *
+ * A stage is a type with static glm::vec2 evaluate(SteeringContext&), so the
+ * compiler inlines the whole chain. The context looks the agent's components
+ * up once, every stage shares them. Weights are std::ratio, C++17 has no
+ * float template arguments.
+ *
+ * Agents using a pipeline carry a SteeringArchetype (pipeline id and target)
+ * instead of AI, AISteeringSystem::addArchetype() says which pipeline an id
+ * runs. Wander and FollowPath keep their state in WanderState and
+ * WaypointsPath components, as with SteeringManager. WeightedSum and
+ * Prioritised combine the same way as SteeringSettings' modes, so a pipeline
+ * gives the same forces as a SteeringManager with the same behaviours and
+ * weights.
+ *
+ * Seek, Flee, Arrive, Pursuit and Evade also have a batch version,
+ * evaluate(sk::AgentBatch&) writing forceX/Y. A pipeline made only of them
+ * (HasBatch) is computed by AISteeringSystem over a gathered AgentBatch,
+ * with the same results. Prioritised then evaluates every stage, the
+ * skipped ones just aren't added.
+ */
+struct SteeringContext {
+    SteeringContext(entt::registry& t_registry, entt::entity t_owner, entt::entity t_target);
+
+    entt::registry& registry;
+    entt::entity    owner;
+    entt::entity    target;
+
+    Transform&      transform;
+    Physics&        physics;
+    LocalFrame      frame;
+
+    // Set by obstacle avoidance, AISteeringSystem marks it after compute
+    entt::entity    avoidedObstacle = entt::null;
+};
+
+// LocalFrame component if the entity has one, computed from Transform and Physics otherwise
+inline LocalFrame getLocalFrame(entt::registry& registry, entt::entity entity) {
+    if(const LocalFrame* frame = registry.try_get<LocalFrame>(entity); frame) {
+        return *frame;
+    }
+
+    return LocalFrame::of(registry.get<Transform>(entity), registry.get<Physics>(entity));
+}
+
+inline SteeringContext::SteeringContext(entt::registry& t_registry, entt::entity t_owner, entt::entity t_target):
+    registry(t_registry), owner(t_owner), target(t_target),
+    transform(t_registry.get<Transform>(t_owner)), physics(t_registry.get<Physics>(t_owner)),
+    frame(getLocalFrame(t_registry, t_owner)) { }
+
+namespace SteeringPipeline {
+    // Stages with static void evaluate(sk::AgentBatch&)
+    template<typename Stage, typename = void>
+    struct HasBatch: std::false_type { };
+
+    template<typename Stage>
+    struct HasBatch<Stage, std::void_t<decltype(Stage::evaluate(std::declval<sk::AgentBatch&>()))>>: std::true_type { };
+
+    // Behaviours which need more than the kernels, SteeringManager runs the same code
+    glm::vec2 obstacleAvoidance(SteeringContext& context);
+    glm::vec2 wallAvoidance(SteeringContext& context);
+    glm::vec2 offsetPursuit(SteeringContext& context, glm::vec2 offset);
+    glm::vec2 hide(SteeringContext& context);
+    glm::vec2 wander(SteeringContext& context);         // zero without WanderState
+    glm::vec2 followPath(SteeringContext& context);     // zero without WaypointsPath
+
+    struct ObstacleAvoidance {
+        static glm::vec2 evaluate(SteeringContext& context) { return obstacleAvoidance(context); }
+    };
+
+    struct WallAvoidance {
+        static glm::vec2 evaluate(SteeringContext& context) { return wallAvoidance(context); }
+    };
+
+    template<int OffsetX, int OffsetY>
+    struct OffsetPursuit {
+        static glm::vec2 evaluate(SteeringContext& context) {
+            return offsetPursuit(context, glm::vec2(float(OffsetX), float(OffsetY)));
+        }
+    };
+
+    struct Hide {
+        static glm::vec2 evaluate(SteeringContext& context) { return hide(context); }
+    };
+
+    struct Wander {
+        static glm::vec2 evaluate(SteeringContext& context) { return wander(context); }
+    };
+
+    struct FollowPath {
+        static glm::vec2 evaluate(SteeringContext& context) { return followPath(context); }
+    };
+
+    // Seek, Flee and Arrive go to the target's current position
+    struct Seek {
+        static void evaluate(sk::AgentBatch& batch) { sk::seek(batch); }
+
+        static glm::vec2 evaluate(SteeringContext& context) {
+            return sk::seek(context.transform.position, context.physics.velocity, context.physics.maxSpeed,
+                            context.registry.get<Transform>(context.target).position);
+        }
+    };
+
+    struct Flee {
+        static void evaluate(sk::AgentBatch& batch) { sk::flee(batch); }
+
+        static glm::vec2 evaluate(SteeringContext& context) {
+            return sk::flee(context.transform.position, context.physics.velocity, context.physics.maxSpeed,
+                            context.registry.get<Transform>(context.target).position);
+        }
+    };
+
+    template<SteeringManager::Deceleration deceleration>
+    struct Arrive {
+        static void evaluate(sk::AgentBatch& batch) { sk::arrive(batch, deceleration); }
+
+        static glm::vec2 evaluate(SteeringContext& context) {
+            return sk::arrive(context.transform.position, context.physics.velocity,
+                              context.registry.get<Transform>(context.target).position, deceleration);
+        }
+    };
+
+    struct Pursuit {
+        static void evaluate(sk::AgentBatch& batch) { sk::pursuit(batch); }
+
+        static glm::vec2 evaluate(SteeringContext& context) {
+            const Transform& targetTransform = context.registry.get<Transform>(context.target);
+            return sk::pursuit(context.transform.position, context.physics.velocity, orientationToVec(context.transform.angle),
+                               context.physics.maxSpeed, targetTransform.position,
+                               context.registry.get<Physics>(context.target).velocity, orientationToVec(targetTransform.angle));
+        }
+    };
+
+    struct Evade {
+        static void evaluate(sk::AgentBatch& batch) { sk::evade(batch); }
+
+        static glm::vec2 evaluate(SteeringContext& context) {
+            return sk::evade(context.transform.position, context.physics.velocity, context.physics.maxSpeed,
+                             context.registry.get<Transform>(context.target).position,
+                             context.registry.get<Physics>(context.target).velocity);
+        }
+    };
+
+    // Combined forces truncated to Physics::maxForce into forceX/Y
+    inline void storeForces(sk::AgentBatch& batch, const std::vector<glm::vec2>& totalForces) {
+        for(std::size_t i = 0; i < batch.size(); ++i) {
+            glm::vec2 force = wrapVector(totalForces[i], batch.maxForce[i]);
+            batch.forceX[i] = force.x;
+            batch.forceY[i] = force.y;
+        }
+    }
+
+    template<typename Stage, typename Weight>
+    struct Weighted {
+        static glm::vec2 evaluate(SteeringContext& context) {
+            return Stage::evaluate(context) * (float(Weight::num) / float(Weight::den));
+        }
+
+        template<typename S = Stage>
+        static std::enable_if_t<HasBatch<S>::value> evaluate(sk::AgentBatch& batch) {
+            S::evaluate(batch);
+
+            float weight = float(Weight::num) / float(Weight::den);
+            for(std::size_t i = 0; i < batch.size(); ++i) {
+                batch.forceX[i] *= weight;
+                batch.forceY[i] *= weight;
+            }
+        }
+    };
+
+    // Every stage, summed in order and truncated to Physics::maxForce
+    template<typename... Stages>
+    struct WeightedSum {
+        static glm::vec2 evaluate(SteeringContext& context) {
+            glm::vec2 totalForce = glm::vec2(0.0f, 0.0f);
+            ((totalForce += Stages::evaluate(context)), ...);
+
+            return wrapVector(totalForce, context.physics.maxForce);
+        }
+
+        template<bool batch = (HasBatch<Stages>::value && ...)>
+        static std::enable_if_t<batch> evaluate(sk::AgentBatch& agents) {
+            // Per template instance, a pipeline can't contain itself
+            thread_local std::vector<glm::vec2> totalForces;
+            totalForces.assign(agents.size(), glm::vec2(0.0f, 0.0f));
+
+            auto add = [&]() {
+                for(std::size_t i = 0; i < agents.size(); ++i) totalForces[i] += agents.getForce(i);
+            };
+            ((Stages::evaluate(agents), add()), ...);
+
+            storeForces(agents, totalForces);
+        }
+    };
+
+    // Stages in priority order while there is force budget left, the rest aren't evaluated
+    template<typename... Stages>
+    struct Prioritised {
+        static glm::vec2 evaluate(SteeringContext& context) {
+            glm::vec2 totalForce = glm::vec2(0.0f, 0.0f);
+            (add<Stages>(context, totalForce) && ...);
+
+            return wrapVector(totalForce, context.physics.maxForce);
+        }
+
+        template<bool batch = (HasBatch<Stages>::value && ...)>
+        static std::enable_if_t<batch> evaluate(sk::AgentBatch& agents) {
+            thread_local std::vector<glm::vec2> totalForces;
+            totalForces.assign(agents.size(), glm::vec2(0.0f, 0.0f));
+
+            // Once an agent's budget is spent its total doesn't change, so later stages keep failing the check
+            auto add = [&]() {
+                for(std::size_t i = 0; i < agents.size(); ++i) {
+                    if(glm::length(totalForces[i]) < agents.maxForce[i] - MINIMAL_SPEED) {
+                        accumulateForce(totalForces[i], agents.getForce(i), agents.maxForce[i]);
+                    }
+                }
+            };
+            ((Stages::evaluate(agents), add()), ...);
+
+            storeForces(agents, totalForces);
+        }
+
+    private:
+        template<typename Stage>
+        static bool add(SteeringContext& context, glm::vec2& totalForce) {
+            if(glm::length(totalForce) >= context.physics.maxForce - MINIMAL_SPEED) {
+                return false;
+            }
+
+            accumulateForce(totalForce, Stage::evaluate(context), context.physics.maxForce);
+            return true;
+        }
+    };
+}
+
+namespace sp = SteeringPipeline;
+
+#endif // STEERINGPIPELINE_H_INCLUDED
@@ -0,0 +1,81 @@
+#ifndef SYSTEMPROFILER_H_INCLUDED
+#define SYSTEMPROFILER_H_INCLUDED
+
+/*
+ * Per-system update() timings, collected by SystemsManager when the game is
+ * built with -DAI_PROFILE_SYSTEMS. Without it nothing of this is compiled in.
+ *
+ * Every system keeps its last WINDOW_SIZE samples; min, mean and p99 are
+ * computed over them when asked. Each system's samples are written only by
+ * the thread running it, so recording takes no locks.
+ */
+#ifdef AI_PROFILE_SYSTEMS
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+struct SystemStats {
+    const char*     name;
+    const char*     phase;
+    std::size_t     samples;
+    double          last;           // ms
+    double          min;
+    double          mean;
+    double          p99;
+    double          max;
+    std::size_t     entities;       // size of the system's main view in the last update
+};
+
+class SystemProfiler {
+public:
+    static constexpr std::size_t WINDOW_SIZE = 128;
+
+    void resize(std::size_t systemsCount) {
+        m_systems.resize(systemsCount);
+    }
+
+    void record(std::size_t system, double milliseconds, std::size_t entities) {
+        Samples& samples = m_systems[system];
+        samples.times[samples.count % WINDOW_SIZE] = milliseconds;
+        samples.count++;
+        samples.entities = entities;
+    }
+
+    SystemStats getStats(std::size_t system, const char* name, const char* phase) const {
+        const Samples& samples = m_systems[system];
+        std::size_t count = std::min(samples.count, WINDOW_SIZE);
+
+        SystemStats stats{name, phase, count, 0.0, 0.0, 0.0, 0.0, 0.0, samples.entities};
+        if(count == 0) return stats;
+
+        std::vector<double> times(samples.times, samples.times + count);
+        stats.last = samples.times[(samples.count - 1) % WINDOW_SIZE];
+
+        double sum = 0.0;
+        for(auto time: times) sum += time;
+        stats.mean = sum / count;
+
+        std::sort(times.begin(), times.end());
+        stats.min = times.front();
+        stats.max = times.back();
+        stats.p99 = times[std::min(count - 1, std::size_t(std::ceil(count * 0.99)) - 1)];
+
+        return stats;
+    }
+
+private:
+    struct Samples {
+        Samples(): count(0), entities(0) { }
+
+        double          times[WINDOW_SIZE];
+        std::size_t     count;
+        std::size_t     entities;
+    };
+
+    std::vector<Samples> m_systems;
+};
+
+#endif // AI_PROFILE_SYSTEMS
+
+#endif // SYSTEMPROFILER_H_INCLUDED
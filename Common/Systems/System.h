@@ -1,6 +1,11 @@
 #ifndef SYSTEM_H_INCLUDED
 #define SYSTEM_H_INCLUDED
 
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+
 #include "entt.hpp"
 #include "../Components/Components.h"
 #include "../Events/Events.h"
@@ -8,27 +13,135 @@
 #include "../../Path.h"
 
 #include "../helper.h"
+#include "../SpatialHashGrid.h"
+#include "../WallBVH.h"
+#include "../Neighbourhood.h"
+#include "../ThreadPool.h"
+#include "../Tracer.h"
+#include "../SteeringPipeline.h"
+#include "../Flocking.h"
+#include "../Orca.h"
+
+/*
+ * Components and context resources a system touches in update().
+ * SystemsManager runs two systems concurrently only if neither of them writes
+ * what the other one reads or writes. Systems which declare nothing are run
+ * alone, as before. A system may assign or remove components it writes()
+ * (e.g. LocalFrame, SteeringLOD): their pools are created before systems run
+ * concurrently. Creating or destroying entities needs a system which
+ * declares nothing.
+ */
+struct SystemAccess {
+    SystemAccess(): declared(false), mainThread(false) { }
+
+    bool conflictsWith(const SystemAccess& other) const {
+        if(!declared || !other.declared) return true;
+
+        return intersects(writes, other.reads) || intersects(writes, other.writes) || intersects(reads, other.writes);
+    }
+
+    std::vector<ENTT_ID_TYPE>               reads;
+    std::vector<ENTT_ID_TYPE>               writes;
+    std::vector<void(*)(entt::registry&)>   preparePools;
+#ifdef AI_PROFILE_SYSTEMS
+    std::size_t                             (*countEntities)(entt::registry&) = nullptr;
+#endif
+    bool                                    declared;
+    bool                                    mainThread;
+
+private:
+    static bool intersects(const std::vector<ENTT_ID_TYPE>& a, const std::vector<ENTT_ID_TYPE>& b) {
+        for(auto id: a) {
+            if(std::find(b.begin(), b.end(), id) != b.end()) return true;
+        }
+
+        return false;
+    }
+};
 
 class ISystem {
 public:
+    virtual ~ISystem() { }
+
     virtual void enter(entt::registry& registry, entt::dispatcher& dispatcher) { }
     virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) = 0;
+
+    virtual const char* getName() const { return "System"; }
+
+    const SystemAccess& getAccess() const { return m_access; }
+
+protected:
+    template<typename... Components>
+    void reads() {
+        (addComponent<Components>(m_access.reads), ...);
+    }
+
+    template<typename... Components>
+    void writes() {
+        (addComponent<Components>(m_access.writes), ...);
+    }
+
+    // Context variables and other shared objects (e.g. SDL_Renderer)
+    template<typename... Resources>
+    void readsResource() {
+        m_access.declared = true;
+        (m_access.reads.push_back(entt::type_info<Resources>::id()), ...);
+    }
+
+    template<typename... Resources>
+    void writesResource() {
+        m_access.declared = true;
+        (m_access.writes.push_back(entt::type_info<Resources>::id()), ...);
+    }
+
+    void runOnMainThread() {
+        m_access.mainThread = true;
+    }
+
+    // Main view of the system, its size is reported by SystemProfiler (for several components it's
+    // the smallest pool, as entt estimates it). Does nothing without AI_PROFILE_SYSTEMS.
+    template<typename... Components>
+    void iterates() {
+#ifdef AI_PROFILE_SYSTEMS
+        m_access.countEntities = [](entt::registry& registry) -> std::size_t {
+            return registry.view<Components...>().size();
+        };
+#endif
+    }
+
+private:
+    // entt creates pools on the first lookup, SystemsManager does it before going parallel
+    template<typename Component>
+    void addComponent(std::vector<ENTT_ID_TYPE>& ids) {
+        m_access.declared = true;
+        ids.push_back(entt::type_info<Component>::id());
+        m_access.preparePools.push_back([](entt::registry& registry) { registry.size<Component>(); });
+    }
+
+    SystemAccess m_access;
 };
 
 class RenderingSystem: public ISystem {
 public:
-    RenderingSystem(SDL_Renderer* renderer): m_renderer(renderer) { }
+    RenderingSystem(SDL_Renderer* renderer): m_renderer(renderer) {
+        iterates<Renderable, Transform, RenderTransform>();
+        reads<Renderable, Transform, RenderTransform>();
+        writesResource<SDL_Renderer>();
+        runOnMainThread();
+    }
+
+    virtual const char* getName() const { return "RenderingSystem"; }
     virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) {
-        auto renderableObjects = registry.view<Renderable, Transform>();
-        renderableObjects.each([&](entt::entity object, Renderable& renderable, Transform& transform){
+        auto renderableObjects = registry.view<Renderable, Transform, RenderTransform>();
+        renderableObjects.each([&](entt::entity object, Renderable& renderable, Transform& transform, RenderTransform& renderTransform){
             if(renderable.texture != NULL) {
                 SDL_Rect destRect;
-                destRect.x = int(std::round(transform.position.x - transform.size.x * transform.scale * 0.5f));
-                destRect.y = int(std::round(transform.position.y - transform.size.y * transform.scale * 0.5f));
+                destRect.x = int(std::round(renderTransform.position.x - transform.size.x * transform.scale * 0.5f));
+                destRect.y = int(std::round(renderTransform.position.y - transform.size.y * transform.scale * 0.5f));
                 destRect.w = int(std::round(transform.size.x * transform.scale));
                 destRect.h = int(std::round(transform.size.y * transform.scale));
 
-                SDL_RenderCopyEx(m_renderer, renderable.texture, NULL, &destRect, transform.angle, NULL, SDL_FLIP_NONE);
+                SDL_RenderCopyEx(m_renderer, renderable.texture, NULL, &destRect, renderTransform.angle, NULL, SDL_FLIP_NONE);
             }
         });
     }
@@ -39,13 +152,20 @@ private:
 
 class ObstacleRenderingSystem: public ISystem {
 public:
-    ObstacleRenderingSystem(SDL_Renderer* renderer): m_renderer(renderer) { }
+    ObstacleRenderingSystem(SDL_Renderer* renderer): m_renderer(renderer) {
+        iterates<Obstacle, Physics, RenderTransform>();
+        reads<Obstacle, Physics, RenderTransform>();
+        writesResource<SDL_Renderer>();
+        runOnMainThread();
+    }
+
+    virtual const char* getName() const { return "ObstacleRenderingSystem"; }
 
     virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) {
-        auto obstaclesView = registry.view<Obstacle, Physics, Transform>();
+        auto obstaclesView = registry.view<Obstacle, Physics, RenderTransform>();
         for(auto obstacle: obstaclesView) {
             Physics& physics = registry.get<Physics>(obstacle);
-            Transform& transform = registry.get<Transform>(obstacle);
+            RenderTransform& transform = registry.get<RenderTransform>(obstacle);
             Obstacle& obst = registry.get<Obstacle>(obstacle);
 
             drawCircle(m_renderer, transform.position, physics.radius, obst.color, 32);
@@ -58,11 +178,18 @@ private:
 
 class ObstacleBoxRenderingSystem: public ISystem {
 public:
-    ObstacleBoxRenderingSystem(SDL_Renderer* renderer): m_renderer(renderer) { }
+    ObstacleBoxRenderingSystem(SDL_Renderer* renderer): m_renderer(renderer) {
+        iterates<RenderTransform, Physics, AI>();
+        reads<RenderTransform, Physics, AI>();
+        writesResource<SDL_Renderer>();
+        runOnMainThread();
+    }
+
+    virtual const char* getName() const { return "ObstacleBoxRenderingSystem"; }
 
     virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) {
-        auto aiView = registry.view<Transform, Physics, AI>();
-        aiView.each([&](entt::entity, Transform& transform, Physics& physics, AI& ai){
+        auto aiView = registry.view<RenderTransform, Physics, AI>();
+        aiView.each([&](entt::entity, RenderTransform& transform, Physics& physics, AI& ai){
             glm::vec2 points[2];
             points[0] = transform.position;
             points[1] = safeNormalize(physics.velocity) * (physics.velocity.length() / physics.maxSpeed * 100.0f + 100.0f) + transform.position;
@@ -78,7 +205,14 @@ private:
 
 class PathRenderingSystem: public ISystem {
 public:
-    PathRenderingSystem(SDL_Renderer* renderer): m_renderer(renderer) { }
+    PathRenderingSystem(SDL_Renderer* renderer): m_renderer(renderer) {
+        iterates<Path>();
+        reads<Path>();
+        writesResource<SDL_Renderer>();
+        runOnMainThread();
+    }
+
+    virtual const char* getName() const { return "PathRenderingSystem"; }
 
     virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) {
         auto pathView = registry.view<Path>();
@@ -114,7 +248,14 @@ private:
 
 class WallRenderingSystem: public ISystem {
 public:
-    WallRenderingSystem(SDL_Renderer* renderer): m_renderer(renderer) { }
+    WallRenderingSystem(SDL_Renderer* renderer): m_renderer(renderer) {
+        iterates<Wall>();
+        reads<Wall>();
+        writesResource<SDL_Renderer>();
+        runOnMainThread();
+    }
+
+    virtual const char* getName() const { return "WallRenderingSystem"; }
 
     virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) {
         auto wallsView = registry.view<Wall>();
@@ -145,8 +286,29 @@ private:
 
 };
 
+// Objects leaving the world (plus a margin) come back from the other side
+inline glm::vec2 wrapAround(glm::vec2 position, glm::vec2 size) {
+    glm::vec2 result(position);
+    if(position.x > size.x + 64) result.x = -64;
+    else if(position.x < -65) result.x = size.x + 63;
+
+    if(position.y > size.y + 64) result.y = -64;
+    else if(position.y < -65) result.y = size.y + 63;
+
+    return result;
+}
+
 class PhysicsSystem: public ISystem {
 public:
+    PhysicsSystem() {
+        iterates<Transform, Physics>();
+        reads<Physics>();
+        writes<Transform>();
+        readsResource<GameData>();
+    }
+
+    virtual const char* getName() const { return "PhysicsSystem"; }
+
     virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) {
         GameData& gameData = registry.ctx<GameData>();
 
@@ -157,25 +319,336 @@ public:
 
         });
     }
+};
+
+// PhysicsSystem for Transform + Kinematic entities, they face where they go
+class KinematicMovementSystem: public ISystem {
+public:
+    KinematicMovementSystem() {
+        iterates<Transform, Kinematic>();
+        reads<Kinematic>();
+        writes<Transform>();
+        readsResource<GameData>();
+    }
+
+    virtual const char* getName() const { return "KinematicMovementSystem"; }
+
+    virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) {
+        GameData& gameData = registry.ctx<GameData>();
+
+        auto kinematicObjects = registry.view<Transform, Kinematic>();
+        kinematicObjects.each([&](entt::entity object, Transform& transform, Kinematic& kinematic) {
+            transform.position = wrapAround(transform.position + kinematic.velocity * delta, gameData.screenSize);
+            if(glm::length(kinematic.velocity) > MINIMAL_SPEED) {
+                transform.angle = vecToOrientation(kinematic.velocity);
+            }
+        });
+    }
+};
+
+// First simulation system: remembers Transform before the step for TransformInterpolationSystem
+class TransformSnapshotSystem: public ISystem {
+public:
+    TransformSnapshotSystem() {
+        iterates<Transform, PreviousTransform>();
+        reads<Transform>();
+        writes<PreviousTransform>();
+    }
+
+    virtual const char* getName() const { return "TransformSnapshotSystem"; }
+
+    virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) {
+        auto transformsView = registry.view<Transform, PreviousTransform>();
+        transformsView.each([&](entt::entity, Transform& transform, PreviousTransform& previous) {
+            previous.position = transform.position;
+            previous.angle = transform.angle;
+        });
+    }
+};
+
+// First rendering system: RenderTransform = lerp(PreviousTransform, Transform, alpha).
+// Objects which moved more than half of the screen in one step were wrapped around, they are not interpolated.
+class TransformInterpolationSystem: public ISystem {
+public:
+    TransformInterpolationSystem() {
+        iterates<Transform, PreviousTransform, RenderTransform>();
+        reads<Transform, PreviousTransform>();
+        writes<RenderTransform>();
+        readsResource<GameData, RenderInterpolation>();
+    }
+
+    virtual const char* getName() const { return "TransformInterpolationSystem"; }
+
+    virtual void enter(entt::registry& registry, entt::dispatcher& dispatcher) {
+        registry.on_construct<Transform>().connect<&TransformInterpolationSystem::onTransformCreated>(*this);
+
+        registry.view<Transform>().each([&](entt::entity entity, Transform& transform) {
+            onTransformCreated(registry, entity);
+        });
+    }
+
+    virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) {
+        float alpha = registry.ctx<RenderInterpolation>().alpha;
+        glm::vec2 maxStep = registry.ctx<GameData>().screenSize * 0.5f;
+
+        auto transformsView = registry.view<Transform, PreviousTransform, RenderTransform>();
+        transformsView.each([&](entt::entity, Transform& transform, PreviousTransform& previous, RenderTransform& render) {
+            glm::vec2 step = transform.position - previous.position;
+            if(std::fabs(step.x) > maxStep.x || std::fabs(step.y) > maxStep.y) {
+                render.position = transform.position;
+            } else {
+                render.position = previous.position + step * alpha;
+            }
+
+            // Shortest way around, angles are in degrees
+            float turn = std::fmod(transform.angle - previous.angle, 360.0f);
+            if(turn > 180.0f) turn -= 360.0f;
+            else if(turn < -180.0f) turn += 360.0f;
+
+            render.angle = previous.angle + turn * alpha;
+        });
+    }
 
 private:
-    glm::vec2 wrapAround(glm::vec2 position, glm::vec2 size) {
-        glm::vec2 result(position);
-        if(position.x > size.x + 64) result.x = -64;
-        else if(position.x < -65) result.x = size.x + 63;
+    void onTransformCreated(entt::registry& registry, entt::entity entity) {
+        const Transform& transform = registry.get<Transform>(entity);
+        registry.assign_or_replace<PreviousTransform>(entity, PreviousTransform{transform.position, transform.angle});
+        registry.assign_or_replace<RenderTransform>(entity, RenderTransform{transform.position, transform.angle});
+    }
+};
+
+class ObstacleGridSystem: public ISystem {
+public:
+    ObstacleGridSystem() {
+        iterates<Transform, Physics, Obstacle>();
+        reads<Transform, Physics, Obstacle>();
+        writesResource<ObstacleGrid>();
+    }
+
+    virtual const char* getName() const { return "ObstacleGridSystem"; }
+
+    virtual void enter(entt::registry& registry, entt::dispatcher& dispatcher) {
+        registry.set<ObstacleGrid>();
+    }
+
+    virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) {
+        ObstacleGrid& grid = registry.ctx<ObstacleGrid>();
+        grid.clear();
 
-        if(position.y > size.y + 64) result.y = -64;
-        else if(position.y < -65) result.y = size.y + 63;
+        auto obstaclesView = registry.view<Transform, Physics, Obstacle>();
+        obstaclesView.each([&](entt::entity obstacle, Transform& transform, Physics& physics, Obstacle&) {
+            grid.insert(obstacle, transform.position, physics.radius);
+        });
+
+        grid.build();
+    }
+};
+
+class WallBVHSystem: public ISystem {
+public:
+    WallBVHSystem() {
+        iterates<Wall>();
+        reads<Wall>();
+        writesResource<WallBVH>();
+    }
+
+    virtual const char* getName() const { return "WallBVHSystem"; }
 
-        return result;
+    virtual void enter(entt::registry& registry, entt::dispatcher& dispatcher) {
+        registry.set<WallBVH>().connect(registry);
+    }
+
+    virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) {
+        registry.ctx<WallBVH>().update(registry);
     }
 };
 
+class NeighbourhoodSystem: public ISystem {
+public:
+    NeighbourhoodSystem(float radius = 100.0f, std::size_t maxNeighbours = 0): m_radius(radius),
+                                                                               m_maxNeighbours(maxNeighbours) {
+        iterates<Transform, Kinematic>();
+        reads<Transform, Kinematic>();
+        writesResource<Neighbourhood>();
+    }
+
+    virtual const char* getName() const { return "NeighbourhoodSystem"; }
+
+    virtual void enter(entt::registry& registry, entt::dispatcher& dispatcher) {
+        registry.set<Neighbourhood>(m_radius, m_maxNeighbours);
+    }
+
+    virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) {
+        registry.ctx<Neighbourhood>().build(registry);
+    }
+
+private:
+    float       m_radius;
+    std::size_t m_maxNeighbours;
+};
+
+// Boids (see Flocking.h): accelerations from the previous tick's state first, then every boid changes its own velocity.
+// KinematicMovementSystem moves them.
+class FlockingSystem: public ISystem {
+public:
+    explicit FlockingSystem(const FlockingSettings& settings = FlockingSettings()):
+        m_settings(settings), m_vectorised(true) {
+        iterates<Transform, Kinematic, Boid>();
+        reads<Transform, Boid>();
+        writes<Kinematic>();
+    }
+
+    virtual const char* getName() const { return "FlockingSystem"; }
+
+    virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) {
+        ThreadPool& pool = registry.ctx<ThreadPool>();
+
+        {
+            TRACE_SCOPE("build", "FlockingSystem");
+            m_grid.build(registry, m_settings.radius);
+        }
+
+        m_grid.computeAccelerations(m_settings, pool, m_vectorised);
+
+        const auto& boids = m_grid.getEntities();
+        const auto& accelerations = m_grid.getAccelerations();
+        auto kinematics = registry.view<Kinematic>();
+        pool.parallelFor(boids.size(), BOIDS_PER_TASK, [&](std::size_t begin, std::size_t end) {
+            TRACE_SCOPE("apply", "FlockingSystem");
+            for(auto i = begin; i < end; ++i) {
+                Kinematic& kinematic = kinematics.get(boids[i]);
+                kinematic.velocity = wrapVector(kinematic.velocity + accelerations[i] * delta, kinematic.maxSpeed);
+            }
+        });
+    }
+
+    FlockingSettings& getSettings() { return m_settings; }
+
+    // false accumulates neighbours one at a time instead of four
+    void setVectorised(bool vectorised) { m_vectorised = vectorised; }
+
+private:
+    static constexpr std::size_t BOIDS_PER_TASK = 1024;
+
+    FlockingSettings    m_settings;
+    bool                m_vectorised;
+    FlockGrid           m_grid;
+};
+
+// Collision free velocities for CrowdAgents (see Orca.h). Motion is Kinematic or Physics: the agent's
+// velocity and maxSpeed, KinematicMovementSystem or PhysicsSystem moves them.
+template<typename Motion>
+class OrcaSystem: public ISystem {
+public:
+    explicit OrcaSystem(const OrcaSettings& settings = OrcaSettings()): m_settings(settings) {
+        iterates<Transform, Motion, CrowdAgent>();
+        reads<Transform, CrowdAgent>();
+        writes<Motion>();
+    }
+
+    virtual const char* getName() const { return "OrcaSystem"; }
+
+    virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) {
+        auto crowd = registry.view<Transform, Motion, CrowdAgent>();
+
+        m_entities.clear();
+        auto& agents = m_solver.getAgents();
+        agents.clear();
+        crowd.each([&](entt::entity entity, Transform& transform, Motion& motion, CrowdAgent& agent) {
+            m_entities.push_back(entity);
+            agents.push_back(OrcaSolver::Agent{transform.position, motion.velocity, agent.preferredVelocity,
+                                               agent.radius, motion.maxSpeed});
+        });
+
+        ThreadPool& pool = registry.ctx<ThreadPool>();
+        m_solver.solve(m_settings, delta, pool);
+
+        const auto& velocities = m_solver.getVelocities();
+        pool.parallelFor(m_entities.size(), AGENTS_PER_TASK, [&](std::size_t begin, std::size_t end) {
+            for(auto i = begin; i < end; ++i) {
+                crowd.template get<Motion>(m_entities[i]).velocity = velocities[i];
+            }
+        });
+    }
+
+    OrcaSettings& getSettings() { return m_settings; }
+
+private:
+    static constexpr std::size_t AGENTS_PER_TASK = 1024;
+
+    OrcaSettings                m_settings;
+    std::vector<entt::entity>   m_entities;
+    OrcaSolver                  m_solver;
+};
+
+// Caches the LocalFrame of every moving entity (obstacles don't move) for AISteeringSystem, add it before that one
+class LocalFrameSystem: public ISystem {
+public:
+    LocalFrameSystem() {
+        iterates<Transform, Physics>();
+        reads<Transform, Physics, Obstacle>();
+        writes<LocalFrame>();
+    }
+
+    virtual const char* getName() const { return "LocalFrameSystem"; }
+
+    // update() assigns LocalFrame while other systems may run, its pool must exist before
+    virtual void enter(entt::registry& registry, entt::dispatcher& dispatcher) {
+        registry.size<LocalFrame>();
+    }
+
+    virtual void update(entt::registry& registry, entt::dispatcher& dispatcher, float delta) {
+        // Entities get their frame on the first update after they got Physics
+        auto moving = registry.view<Transform, Physics>(entt::exclude<Obstacle>);
+        moving.each([&](entt::entity entity, Transform& transform, Physics& physics) {
+            registry.assign_or_replace<LocalFrame>(entity, LocalFrame::of(transform, physics));
+        });
+    }
+};
+
+/*
+ * Steering runs in two phases, both spread over the ThreadPool from the context:
+ * compute - every agent calculates its force from the previous tick's state into m_forces,
+ * apply   - every agent integrates its own force.
+ * Each agent writes only its own state components (WanderState, WaypointsPath) during compute, so results
+ * don't depend on the number of threads.
+ * Writes to other entities (marking avoided obstacles) are done afterwards in agents order.
+ *
+ * Agents are AI ones (SteeringManager over their components) followed by SteeringArchetype ones grouped by
+ * archetype, every group computed by its pipeline in one loop without virtual calls. AI wins if an agent
+ * has both.
+ *
+ * With SteeringLODSettings in the context only due agents are computed, in priority order and within the
+ * budget, the others apply their last force again (see GameData.h). Which agents a budget defers depends
+ * on timing, without a budget results still don't depend on the number of threads.
+ */
 class AISteeringSystem: public ISystem {
 public:
-    AISteeringSystem(): m_target(200.0f, 200.0f) { }
+    AISteeringSystem(): m_target(200.0f, 200.0f) {
+        iterates<Transform, Physics, AI>();
+        reads<AI, SteeringArchetype, Controllable, Wall, LocalFrame>();
+        writes<Transform, Physics, Obstacle, WanderState, WaypointsPath, SteeringLOD>();
+        readsResource<ObstacleGrid, WallBVH, SteeringLODSettings>();
+        writesResource<SteeringLODStats>();
+    }
+
+    virtual const char* getName() const { return "AISteeringSystem"; }
+
+    // Agents with SteeringArchetype::id == id are steered by Pipeline (see SteeringPipeline.h)
+    template<typename Pipeline>
+    void addArchetype(std::uint16_t id) {
+        if(m_archetypes.size() <= id) {
+            m_archetypes.resize(id + 1, nullptr);
+        }
+
+        m_archetypes[id] = &computeArchetype<Pipeline>;
+    }
 
     virtual void enter(entt::registry& registry, entt::dispatcher& dispatcher) {
+        // update() assigns SteeringLOD while other systems may run
+        registry.size<SteeringLOD>();
+        registry.set<SteeringLODStats>();
+
         dispatcher.sink<MouseEvent>().connect<&AISteeringSystem::onMouseEvent>(*this);
         auto path = std::make_shared<SegmentedPath>();
         path->setPath({
@@ -202,17 +675,57 @@ public:
         }
 
         auto aiobjects = registry.view<Transform, Physics, AI>();
-        aiobjects.each([&](entt::entity object, Transform& transform, Physics& physics, AI& ai) {
-            //ai.manager->target = player;
+        m_agents.assign(aiobjects.begin(), aiobjects.end());
+        std::size_t managersCount = m_agents.size();
+
+        gatherArchetypes(registry);
+        m_forces.resize(m_agents.size());
+        m_avoidedObstacles.resize(m_agents.size());
+
+        // entt creates pools on the first lookup, that mustn't happen on worker threads
+        registry.size<Obstacle>();
+        registry.size<Wall>();
+        registry.size<LocalFrame>();
+        registry.size<WanderState>();
+        registry.size<WaypointsPath>();
+
+        ThreadPool& pool = registry.ctx<ThreadPool>();
+        const SteeringLODSettings* lod = registry.try_ctx<SteeringLODSettings>();
+
+        if(lod == nullptr) {
+            pool.parallelFor(m_agents.size(), AGENTS_PER_TASK, [&](std::size_t begin, std::size_t end) {
+                TRACE_SCOPE("compute", "AISteeringSystem");
+                computeAgents(registry, begin, end, managersCount);
+            });
+        } else {
+            glm::vec2 focus = registry.valid(player) ? registry.get<Transform>(player).position : lod->focus;
+            scheduleLOD(registry, *lod, focus);
+            computeLOD(registry, *lod, managersCount);
+        }
+
+        auto transforms = registry.view<Transform, Physics>();
+        pool.parallelFor(m_agents.size(), AGENTS_PER_TASK, [&](std::size_t begin, std::size_t end) {
+            TRACE_SCOPE("apply", "AISteeringSystem");
+            for(auto i = begin; i < end; ++i) {
+                Transform& transform = transforms.get<Transform>(m_agents[i]);
+                Physics& physics = transforms.get<Physics>(m_agents[i]);
 
-            glm::vec2 force = safeNormalize(ai.manager->calculate());
-            //We temporary make result force maximal
+                if(lod != nullptr) {
+                    reuseForce(registry.get<SteeringLOD>(m_agents[i]), *lod, i);
+                }
 
-            glm::vec2 acceleration = force * (1.0f / physics.mass) * physics.maxForce;
-            physics.velocity = wrapVector(physics.velocity + acceleration * delta, physics.maxSpeed);
+                glm::vec2 acceleration = m_forces[i] * (1.0f / physics.mass);
+                physics.velocity = wrapVector(physics.velocity + acceleration * delta, physics.maxSpeed);
 
-            transform.angle = vecToOrientation(physics.velocity);
+                transform.angle = vecToOrientation(physics.velocity);
+            }
         });
+
+        for(entt::entity obstacle: m_avoidedObstacles) {
+            if(registry.valid(obstacle) && registry.has<Obstacle>(obstacle)) {
+                registry.get<Obstacle>(obstacle).color = SDL_Color {255, 0, 0 };
+            }
+        }
     }
 
     void onMouseEvent(const MouseEvent& event) {
@@ -221,9 +734,247 @@ public:
     }
 
 private:
+    using ArchetypeFunction = void (*)(entt::registry&, const entt::entity* agents, const entt::entity* targets,
+                                       std::size_t count, glm::vec2* forces, entt::entity* avoidedObstacles);
+
+    // Agents [begin, end) have the archetype id
+    struct ArchetypeRange {
+        std::uint16_t   id;
+        std::size_t     begin;
+        std::size_t     end;
+    };
+
+    // Agents [begin, end) of m_agents
+    void computeAgents(entt::registry& registry, std::size_t begin, std::size_t end, std::size_t managersCount) {
+        for(auto i = begin; i < std::min(end, managersCount); ++i) {
+            SteeringManager manager(&registry, m_agents[i]);
+            m_forces[i] = manager.calculate();
+            m_avoidedObstacles[i] = manager.getAvoidedObstacle();
+        }
+
+        // Part of every archetype group in [begin, end)
+        for(const ArchetypeRange& range: m_ranges) {
+            std::size_t rangeBegin = std::max(begin, range.begin), rangeEnd = std::min(end, range.end);
+            if(rangeBegin < rangeEnd) {
+                m_archetypes[range.id](registry, m_agents.data() + rangeBegin, m_targets.data() + rangeBegin - managersCount,
+                                       rangeEnd - rangeBegin, m_forces.data() + rangeBegin, m_avoidedObstacles.data() + rangeBegin);
+            }
+        }
+    }
+
+    // Gives every agent its level and orders the due ones into m_due: level by level, within a level
+    // the deferred (overdue) agents first
+    void scheduleLOD(entt::registry& registry, const SteeringLODSettings& settings, glm::vec2 focus) {
+        TRACE_SCOPE("schedule", "AISteeringSystem");
+        const int levelsCount = SteeringLODSettings::LEVELS_COUNT;
+
+        for(auto agent: m_agents) {
+            if(!registry.has<SteeringLOD>(agent)) {
+                registry.assign<SteeringLOD>(agent);
+            }
+        }
+
+        // Static obstacles are in the last force already, only moving ones are threats. There are few of them,
+        // so they get their own grid instead of filtering ObstacleGrid for every agent.
+        if(m_threats.getCellSize() != settings.threatDistance) {
+            m_threats = SpatialHashGrid(settings.threatDistance);
+        }
+
+        m_threats.clear();
+        registry.view<Transform, Physics, Obstacle>().each([&](entt::entity obstacle, Transform& transform, Physics& physics, Obstacle&) {
+            if(glm::dot(physics.velocity, physics.velocity) > MINIMAL_SPEED) {
+                m_threats.insert(obstacle, transform.position, physics.radius);
+            }
+        });
+        m_threats.build();
+
+        auto agents = registry.view<Transform, SteeringLOD>();
+        m_buckets.resize(m_agents.size());
+
+        registry.ctx<ThreadPool>().parallelFor(m_agents.size(), AGENTS_PER_TASK, [&](std::size_t begin, std::size_t end) {
+            for(auto i = begin; i < end; ++i) {
+                glm::vec2 position = agents.get<Transform>(m_agents[i]).position;
+                SteeringLOD& state = agents.get<SteeringLOD>(m_agents[i]);
+
+                float distance = glm::distance(position, focus);
+                int level = 0;
+                while(level < levelsCount - 1 && distance > settings.levelDistances[level]) {
+                    ++level;
+                }
+
+                if(level > 0) {
+                    m_threats.queryRadius(position, settings.threatDistance, [&](const SpatialHashGrid::Item& item) {
+                        if(item.entity != m_agents[i]) level = 0;
+                    });
+                }
+
+                state.level = std::uint8_t(level);
+                state.age = std::uint16_t(std::min(state.age + 1, 0xFFFF));
+
+                int interval = std::max(1, settings.intervals[level]);
+                if(!state.computed || state.age >= interval) {
+                    m_buckets[i] = std::uint8_t(level * 2 + (state.age > interval ? 0 : 1));
+                } else {
+                    m_buckets[i] = NOT_DUE;
+                }
+            }
+        });
+
+        // Counting sort, stable so agents keep their order within a bucket
+        std::size_t starts[levelsCount * 2 + 1] = {};
+        for(auto bucket: m_buckets) {
+            if(bucket != NOT_DUE) ++starts[bucket + 1];
+        }
+        for(int bucket = 0; bucket < levelsCount * 2; ++bucket) {
+            starts[bucket + 1] += starts[bucket];
+        }
+
+        m_mandatoryCount = starts[2];
+        m_due.resize(starts[levelsCount * 2]);
+        for(std::size_t i = 0; i < m_agents.size(); ++i) {
+            if(m_buckets[i] != NOT_DUE) m_due[starts[m_buckets[i]]++] = i;
+        }
+    }
+
+    // Computes m_due in order until the budget is spent, level 0 always; m_computed marks who was computed
+    void computeLOD(entt::registry& registry, const SteeringLODSettings& settings, std::size_t managersCount) {
+        m_computed.assign(m_agents.size(), 0);
+        std::fill(m_avoidedObstacles.begin(), m_avoidedObstacles.end(), entt::null);
+
+        auto start = std::chrono::steady_clock::now();
+        auto overBudget = [&]() {
+            std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+            return elapsed.count() > settings.budgetMicroseconds;
+        };
+
+        // Every thread claims the next few due agents from a shared cursor, so they are computed in priority
+        // order whichever thread runs them (fixed chunks would start from the back of m_due on the calling
+        // thread). The clock is read once per claim, it costs about as much as a seek.
+        ThreadPool& pool = registry.ctx<ThreadPool>();
+        std::atomic<std::size_t> next(0);
+        pool.parallelFor(pool.getThreadsCount(), 1, [&](std::size_t, std::size_t) {
+            TRACE_SCOPE("compute", "AISteeringSystem");
+            while(true) {
+                std::size_t begin = next.fetch_add(BUDGET_CHECK_INTERVAL);
+                if(begin >= m_due.size()) break;
+                if(begin >= m_mandatoryCount && settings.budgetMicroseconds > 0.0 && overBudget()) break;
+
+                std::size_t end = std::min(begin + BUDGET_CHECK_INTERVAL, m_due.size());
+                for(auto k = begin; k < end; ++k) {
+                    computeAgents(registry, m_due[k], m_due[k] + 1, managersCount);
+                    m_computed[m_due[k]] = 1;
+                }
+            }
+        });
+
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+        SteeringLODStats& stats = registry.ctx<SteeringLODStats>();
+        stats = SteeringLODStats();
+        stats.computeMicroseconds = elapsed.count();
+
+        auto agents = registry.view<SteeringLOD>();
+        for(auto agent: m_agents) {
+            ++stats.agents[agents.get(agent).level];
+        }
+        for(auto i: m_due) {
+            int level = agents.get(m_agents[i]).level;
+            ++(m_computed[i] ? stats.updated[level] : stats.deferred[level]);
+        }
+    }
+
+    // Stores the force of a computed agent, gives the last one to the others
+    void reuseForce(SteeringLOD& state, const SteeringLODSettings& settings, std::size_t i) {
+        if(!m_computed[i]) {
+            m_forces[i] = state.force;
+            return;
+        }
+
+        // The first time agents of a level are spread over its interval, so they aren't all due on the same tick
+        int interval = std::max(1, settings.intervals[state.level]);
+        state.age = state.computed ? 0 : std::uint16_t(entt::to_integral(m_agents[i]) % interval);
+        state.force = m_forces[i];
+        state.computed = true;
+    }
+
+    // Pipelines of kernel stages only run over the gathered group, the others agent by agent
+    template<typename Pipeline>
+    static void computeArchetype(entt::registry& registry, const entt::entity* agents, const entt::entity* targets,
+                                 std::size_t count, glm::vec2* forces, entt::entity* avoidedObstacles) {
+        if constexpr(sp::HasBatch<Pipeline>::value) {
+            thread_local sk::AgentBatch batch;
+            sk::gather(registry, Span<const entt::entity>(agents, count), Span<const entt::entity>(targets, count), batch);
+            Pipeline::evaluate(batch);
+
+            for(std::size_t i = 0; i < count; ++i) {
+                forces[i] = batch.getForce(i);
+                avoidedObstacles[i] = entt::null;
+            }
+            return;
+        }
+
+        for(std::size_t i = 0; i < count; ++i) {
+            SteeringContext context(registry, agents[i], targets[i]);
+            forces[i] = Pipeline::evaluate(context);
+            avoidedObstacles[i] = context.avoidedObstacle;
+        }
+    }
+
+    // Appends archetype agents to m_agents grouped by id, agents of unregistered archetypes are skipped
+    void gatherArchetypes(entt::registry& registry) {
+        m_ranges.clear();
+        m_targets.clear();
+        if(m_archetypes.empty()) {
+            return;
+        }
+
+        // An agent with AI too is already steered by its SteeringManager
+        auto archetypes = registry.view<Transform, Physics, SteeringArchetype>(entt::exclude<AI>);
+        m_groups.resize(m_archetypes.size());
+        for(auto& group: m_groups) {
+            group.clear();
+        }
+
+        for(auto agent: archetypes) {
+            const SteeringArchetype& archetype = archetypes.get<SteeringArchetype>(agent);
+            if(archetype.id < m_archetypes.size() && m_archetypes[archetype.id] != nullptr) {
+                m_groups[archetype.id].push_back(agent);
+            }
+        }
+
+        for(std::uint16_t id = 0; id < m_groups.size(); ++id) {
+            if(m_groups[id].empty()) {
+                continue;
+            }
+
+            m_ranges.push_back(ArchetypeRange{id, m_agents.size(), m_agents.size() + m_groups[id].size()});
+            for(auto agent: m_groups[id]) {
+                m_agents.push_back(agent);
+                m_targets.push_back(archetypes.get<SteeringArchetype>(agent).target);
+            }
+        }
+    }
+
+    static constexpr std::size_t AGENTS_PER_TASK = 256;
+    static constexpr std::size_t BUDGET_CHECK_INTERVAL = 16;
+    static constexpr std::uint8_t NOT_DUE = 0xFF;
+
     glm::vec2 m_target;
     entt::entity m_path;
 
+    std::vector<entt::entity> m_agents;
+    std::vector<glm::vec2> m_forces;
+    std::vector<entt::entity> m_avoidedObstacles;
+
+    std::vector<ArchetypeFunction> m_archetypes;
+    std::vector<std::vector<entt::entity>> m_groups;
+    std::vector<ArchetypeRange> m_ranges;
+    std::vector<entt::entity> m_targets;        // of archetype agents, from m_agents[managersCount]
+
+    std::vector<std::uint8_t> m_buckets;        // LOD: level * 2 + (0 overdue, 1 on time), NOT_DUE
+    std::vector<std::size_t> m_due;             // indices to m_agents, in compute order
+    std::size_t m_mandatoryCount = 0;           // level 0 ones at the front of m_due
+    std::vector<std::uint8_t> m_computed;
+    SpatialHashGrid m_threats;
 };
 
 #endif // SYSTEM_H_INCLUDED
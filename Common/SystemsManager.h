@@ -3,33 +3,272 @@
 
 #include <memory>
 #include <vector>
+#include <atomic>
+#include <chrono>
+#include <ostream>
 
 using std::shared_ptr;
 using std::vector;
 
 #include "Systems/System.h"
+#include "ThreadPool.h"
+#include "SystemProfiler.h"
+#include "Tracer.h"
 
+#ifdef AI_PROFILE_SYSTEMS
+#include <cstdio>
+#include <string>
+#endif
+
+enum class SystemPhase { SIMULATION, RENDERING };
+
+/*
+ * Systems are run as a dependency graph on the ThreadPool from the context.
+ * The parallel systems (AISteeringSystem, FlockingSystem, OrcaSystem) use
+ * the same pool, whoever runs them without a SystemsManager sets one.
+ *
+ * A system depends on every system added before it whose SystemAccess
+ * conflicts with its own, so conflicting systems keep the order they were
+ * added in, and the rest run concurrently. Systems marked runOnMainThread()
+ * are run only by the thread calling update().
+ *
+ * Simulation and rendering systems are separate graphs: simulate() may run
+ * several times per frame with a fixed delta, render() once per frame.
+ * Rendering systems get the time since the last render() as delta and find
+ * the interpolation factor in the RenderInterpolation context variable.
+ *
+ * With -DAI_PROFILE_SYSTEMS every update() is also recorded in a
+ * SystemProfiler, see getSystemStats() and setStatsDump().
+ */
 class SystemsManager {
 public:
-    void addSystem(shared_ptr<ISystem> system) {
-        m_systems.push_back(system);
+    struct ScheduleEntry {
+        std::size_t     thread;
+        double          start;      // ms since the beginning of the phase
+        double          end;
+    };
+
+    explicit SystemsManager(std::size_t threadsCount = 0): m_trace(nullptr), m_frame(0) {
+        m_registry.set<ThreadPool>(threadsCount);
+        m_registry.set<RenderInterpolation>();
+    }
+
+#ifdef AI_PROFILE_SYSTEMS
+    ~SystemsManager() {
+        if(m_statsFile != nullptr) fclose(m_statsFile);
+    }
+#endif
+
+    void addSystem(shared_ptr<ISystem> system, SystemPhase phase = SystemPhase::SIMULATION) {
+        Graph& graph = getGraph(phase);
+        graph.systems.push_back(system);
+        graph.dirty = true;
         system->enter(m_registry, m_dispatcher);
     }
 
+    // Both phases, with nothing to interpolate
     void update(float delta) {
-        for(auto system : m_systems) {
-            system->update(m_registry, m_dispatcher, delta);
+        simulate(delta);
+        render(1.0f, delta);
+    }
+
+    void simulate(float delta) {
+        runGraph(m_simulation, delta);
+
+#ifdef AI_PROFILE_SYSTEMS
+        if(m_statsFile != nullptr && ++m_statsStep % m_statsPeriod == 0) dumpStats();
+#endif
+    }
+
+    // alpha in [0, 1]: where the frame lies between the previous and the last simulation step
+    void render(float alpha, float delta) {
+        m_registry.ctx<RenderInterpolation>().alpha = alpha;
+        runGraph(m_rendering, delta);
+
+        m_frame++;
+    }
+
+#ifdef AI_PROFILE_SYSTEMS
+    // Simulation systems first, in the order they were added
+    vector<SystemStats> getSystemStats() const {
+        vector<SystemStats> stats;
+        for(const Graph* graph : {&m_simulation, &m_rendering}) {
+            for(auto i = 0u; i < graph->systems.size(); ++i) {
+                stats.push_back(graph->profiler.getStats(i, graph->systems[i]->getName(), graph->name));
+            }
         }
+
+        return stats;
+    }
+
+    // Appends stats of every system to a CSV file every periodSteps simulation steps, empty fileName stops it
+    bool setStatsDump(const std::string& fileName, std::size_t periodSteps = 60) {
+        if(m_statsFile != nullptr) fclose(m_statsFile);
+        m_statsFile = nullptr;
+        if(fileName.empty()) return true;
+
+        m_statsFile = fopen(fileName.c_str(), "w");
+        if(m_statsFile == nullptr) return false;
+
+        m_statsPeriod = std::max<std::size_t>(periodSteps, 1);
+        m_statsStep = 0;
+        fprintf(m_statsFile, "step,frame,phase,system,samples,last_ms,min_ms,mean_ms,p99_ms,max_ms,entities\n");
+        return true;
+    }
+#endif
+
+    // Prints the schedule of every phase to stream, nullptr turns it off
+    void setScheduleTrace(std::ostream* stream) { m_trace = stream; }
+
+    // Systems in the order they were added
+    const vector<ScheduleEntry>& getLastSchedule(SystemPhase phase = SystemPhase::SIMULATION) {
+        return getGraph(phase).schedule;
     }
 
     entt::registry& getRegistry() { return m_registry; }
     entt::dispatcher& getDispatcher() { return m_dispatcher; }
 
 private:
+    struct Graph {
+        Graph(const char* graphName): name(graphName), dirty(true) { }
+
+        const char*                         name;
+        vector<shared_ptr<ISystem>>         systems;
+        bool                                dirty;
+#ifdef AI_PROFILE_SYSTEMS
+        SystemProfiler                      profiler;
+#endif
+
+        vector<vector<std::size_t>>         predecessors;
+        vector<vector<std::size_t>>         successors;
+        vector<std::atomic<std::size_t>>    remaining;
+
+        std::chrono::steady_clock::time_point start;
+        vector<ScheduleEntry>               schedule;
+    };
+
+    Graph& getGraph(SystemPhase phase) {
+        return (phase == SystemPhase::SIMULATION) ? m_simulation : m_rendering;
+    }
+
+    void runGraph(Graph& graph, float delta) {
+        if(graph.dirty) buildGraph(graph);
+
+        for(auto& system : graph.systems) {
+            for(auto preparePool : system->getAccess().preparePools) {
+                preparePool(m_registry);
+            }
+        }
+
+        for(auto i = 0u; i < graph.systems.size(); ++i) {
+            graph.remaining[i] = graph.predecessors[i].size();
+        }
+
+        graph.start = std::chrono::steady_clock::now();
+
+        ThreadPool& pool = m_registry.ctx<ThreadPool>();
+        ThreadPool::TaskGroup group;
+        for(auto i = 0u; i < graph.systems.size(); ++i) {
+            if(graph.predecessors[i].empty()) runSystem(pool, group, graph, i, delta);
+        }
+
+        pool.wait(group);
+
+        if(m_trace != nullptr) printSchedule(*m_trace, graph);
+    }
+
+    void buildGraph(Graph& graph) {
+        std::size_t count = graph.systems.size();
+
+        graph.predecessors.assign(count, {});
+        graph.successors.assign(count, {});
+        for(auto i = 0u; i < count; ++i) {
+            for(auto j = 0u; j < i; ++j) {
+                if(graph.systems[j]->getAccess().conflictsWith(graph.systems[i]->getAccess())) {
+                    graph.predecessors[i].push_back(j);
+                    graph.successors[j].push_back(i);
+                }
+            }
+        }
+
+        graph.remaining = vector<std::atomic<std::size_t>>(count);
+        graph.schedule.assign(count, ScheduleEntry{0, 0.0, 0.0});
+#ifdef AI_PROFILE_SYSTEMS
+        graph.profiler.resize(count);
+#endif
+        graph.dirty = false;
+    }
+
+    void runSystem(ThreadPool& pool, ThreadPool::TaskGroup& group, Graph& graph, std::size_t index, float delta) {
+        pool.run(group, [this, &pool, &group, &graph, index, delta]() {
+            ScheduleEntry& entry = graph.schedule[index];
+            entry.thread = pool.getCurrentThreadIndex();
+            entry.start = millisecondsSince(graph.start);
+
+            {
+                TRACE_SCOPE(graph.systems[index]->getName(), graph.name);
+                graph.systems[index]->update(m_registry, m_dispatcher, delta);
+            }
+
+            entry.end = millisecondsSince(graph.start);
+
+#ifdef AI_PROFILE_SYSTEMS
+            auto countEntities = graph.systems[index]->getAccess().countEntities;
+            graph.profiler.record(index, entry.end - entry.start, countEntities ? countEntities(m_registry) : 0);
+#endif
+
+            for(auto successor : graph.successors[index]) {
+                if(--graph.remaining[successor] == 0) runSystem(pool, group, graph, successor, delta);
+            }
+        }, graph.systems[index]->getAccess().mainThread);
+    }
+
+    static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+    void printSchedule(std::ostream& stream, const Graph& graph) const {
+        if(graph.systems.empty()) return;
+
+        stream << "frame " << m_frame << " " << graph.name << "\n";
+        for(auto i = 0u; i < graph.systems.size(); ++i) {
+            const ScheduleEntry& entry = graph.schedule[i];
+            stream << "  " << graph.systems[i]->getName() << ": thread " << entry.thread
+                   << ", " << entry.start << " - " << entry.end << " ms, after";
+
+            if(graph.predecessors[i].empty()) stream << " -";
+            for(auto predecessor : graph.predecessors[i]) {
+                stream << " " << graph.systems[predecessor]->getName();
+            }
+
+            stream << "\n";
+        }
+    }
+
     entt::registry m_registry;
     entt::dispatcher m_dispatcher;
 
-    vector<shared_ptr<ISystem>> m_systems;
+    Graph m_simulation{"simulation"};
+    Graph m_rendering{"rendering"};
+
+    std::ostream* m_trace;
+    std::size_t m_frame;
+
+#ifdef AI_PROFILE_SYSTEMS
+    void dumpStats() {
+        for(const auto& stats : getSystemStats()) {
+            fprintf(m_statsFile, "%zu,%zu,%s,%s,%zu,%.4f,%.4f,%.4f,%.4f,%.4f,%zu\n", m_statsStep, m_frame, stats.phase, stats.name,
+                    stats.samples, stats.last, stats.min, stats.mean, stats.p99, stats.max, stats.entities);
+        }
+
+        fflush(m_statsFile);
+    }
+
+    FILE* m_statsFile = nullptr;
+    std::size_t m_statsPeriod = 60;
+    std::size_t m_statsStep = 0;
+#endif
 };
 
 
@@ -0,0 +1,239 @@
+#ifndef THREADPOOL_H_INCLUDED
+#define THREADPOOL_H_INCLUDED
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+
+/*
+ * Work stealing thread pool.
+ *
+ * Every thread has its own queue: it pushes and pops its tasks at the back,
+ * idle threads steal from the front of the other queues. Slot 0 belongs to
+ * the thread which calls the pool from outside (the main thread), slots 1..n
+ * to the workers.
+ *
+ * Tasks are counted in a TaskGroup. wait() doesn't block while there is work:
+ * it runs queued tasks until the group is finished, so tasks may run() and
+ * wait() for subtasks, and parallelFor() may be nested.
+ *
+ * Tasks run with mainThread = true go to a separate queue which only slot 0
+ * takes from (SDL rendering must stay on the thread that created the window).
+ * They run only while the main thread is inside wait().
+ */
+class ThreadPool {
+public:
+    class TaskGroup {
+    public:
+        TaskGroup(): m_pending(0) { }
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+    private:
+        friend class ThreadPool;
+        std::atomic<std::size_t> m_pending;
+    };
+
+    // threadsCount includes the calling thread, 0 means one per hardware thread
+    explicit ThreadPool(std::size_t threadsCount = 0): m_queuedTasks(0), m_mainQueuedTasks(0), m_finished(false) {
+        if(threadsCount == 0) {
+            threadsCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        for(auto i = 0u; i < threadsCount; ++i) {
+            m_queues.emplace_back(new Queue());
+        }
+
+        for(auto i = 1u; i < threadsCount; ++i) {
+            m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_finished = true;
+        }
+        m_wakeUp.notify_all();
+
+        for(auto& worker: m_workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void run(TaskGroup& group, std::function<void()> function, bool mainThread = false) {
+        group.m_pending++;
+
+        // Counted before it's pushed, so a thief never sees more tasks than counted
+        (mainThread ? m_mainQueuedTasks : m_queuedTasks)++;
+
+        Queue& queue = mainThread ? m_mainQueue : *m_queues[getCurrentThreadIndex()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(Task{std::move(function), &group});
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+        }
+
+        if(mainThread) m_wakeUp.notify_all();
+        else m_wakeUp.notify_one();
+    }
+
+    // Runs queued tasks until every task of the group is finished
+    void wait(TaskGroup& group) {
+        std::size_t index = getCurrentThreadIndex();
+
+        while(group.m_pending > 0) {
+            Task task;
+            if(takeTask(index, task)) {
+                execute(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wakeUp.wait(lock, [&]() {
+                return group.m_pending == 0 || m_queuedTasks > 0 || (index == 0 && m_mainQueuedTasks > 0);
+            });
+        }
+    }
+
+    // Calls function(begin, end) for every chunk of [0, count) and waits for all of them.
+    // Chunk boundaries depend only on count and grainSize, never on the number of threads.
+    template<typename Function>
+    void parallelFor(std::size_t count, std::size_t grainSize, Function function) {
+        grainSize = std::max<std::size_t>(grainSize, 1);
+
+        if(m_workers.empty() || count <= grainSize) {
+            for(std::size_t begin = 0; begin < count; begin += grainSize) {
+                function(begin, std::min(begin + grainSize, count));
+            }
+
+            return;
+        }
+
+        TaskGroup group;
+        for(std::size_t begin = 0; begin < count; begin += grainSize) {
+            std::size_t end = std::min(begin + grainSize, count);
+            run(group, [&function, begin, end]() { function(begin, end); });
+        }
+
+        wait(group);
+    }
+
+    std::size_t getThreadsCount() const { return m_queues.size(); }
+
+    // 0 for the main thread (or any thread outside of the pool), 1..n for workers
+    std::size_t getCurrentThreadIndex() const {
+        return (currentPool() == this) ? currentIndex() : 0;
+    }
+
+private:
+    struct Task {
+        std::function<void()>   function;
+        TaskGroup*              group;
+    };
+
+    struct Queue {
+        std::mutex              mutex;
+        std::deque<Task>        tasks;
+    };
+
+    static const ThreadPool*& currentPool() {
+        thread_local const ThreadPool* pool = nullptr;
+        return pool;
+    }
+
+    static std::size_t& currentIndex() {
+        thread_local std::size_t index = 0;
+        return index;
+    }
+
+    void workerLoop(std::size_t index) {
+        currentPool() = this;
+        currentIndex() = index;
+
+        while(true) {
+            Task task;
+            if(takeTask(index, task)) {
+                execute(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_sleepMutex);
+            m_wakeUp.wait(lock, [this]() { return m_finished || m_queuedTasks > 0; });
+            if(m_finished) return;
+        }
+    }
+
+    bool takeTask(std::size_t index, Task& task) {
+        if(index == 0 && m_mainQueuedTasks > 0 && popFront(m_mainQueue, task)) {
+            m_mainQueuedTasks--;
+            return true;
+        }
+
+        if(m_queuedTasks == 0) return false;
+
+        Queue& own = *m_queues[index];
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if(!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                m_queuedTasks--;
+                return true;
+            }
+        }
+
+        for(auto i = 1u; i < m_queues.size(); ++i) {
+            if(popFront(*m_queues[(index + i) % m_queues.size()], task)) {
+                m_queuedTasks--;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static bool popFront(Queue& queue, Task& task) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.tasks.empty()) return false;
+
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    void execute(Task& task) {
+        task.function();
+
+        if(--task.group->m_pending == 0) {
+            std::lock_guard<std::mutex> lock(m_sleepMutex);
+            m_wakeUp.notify_all();
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    Queue                       m_mainQueue;
+    std::vector<std::thread>    m_workers;
+
+    std::atomic<std::size_t>    m_queuedTasks;
+    std::atomic<std::size_t>    m_mainQueuedTasks;
+
+    std::mutex                  m_sleepMutex;
+    std::condition_variable     m_wakeUp;
+    bool                        m_finished;
+};
+
+#endif // THREADPOOL_H_INCLUDED
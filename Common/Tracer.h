@@ -0,0 +1,213 @@
+#ifndef TRACER_H_INCLUDED
+#define TRACER_H_INCLUDED
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+
+/*
+ * Timeline of frames, systems and steering behaviours in the Chrome
+ * trace-event format, for chrome://tracing or ui.perfetto.dev.
+ *
+ * capture(frames, fileName) records the next frames frames and writes the
+ * file after the last one. A frame ends when the game calls nextFrame(),
+ * which has to happen on the main thread while no scope is open. A capture
+ * still running at exit is written by stop().
+ *
+ * TRACE_SCOPE(name, category) records the time until the end of the block.
+ * Names and categories are not copied, they have to outlive the capture
+ * (string literals, ISystem::getName()). Every thread appends to its own
+ * preallocated buffer without locks; events past its capacity are dropped
+ * and counted. When nothing is recorded a scope costs one relaxed atomic
+ * load; with -DAI_NO_TRACE the macro expands to nothing.
+ */
+class Tracer {
+public:
+    class Scope {
+    public:
+        Scope(const char* name, const char* category): m_name(name), m_category(category),
+                                                       m_start(Tracer::getInstance().isRecording() ? now() : -1) { }
+
+        ~Scope() {
+            if(m_start >= 0) Tracer::getInstance().record(m_name, m_category, m_start, now());
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* m_name;
+        const char* m_category;
+        int64_t     m_start;
+    };
+
+    static Tracer& getInstance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    // Starts recording at the next nextFrame(), eventsPerThread is the capacity of every thread's buffer
+    void capture(std::size_t framesCount, const std::string& fileName, std::size_t eventsPerThread = 1 << 18) {
+        m_pendingFrames = framesCount;
+        m_fileName = fileName;
+        m_capacity = eventsPerThread;
+    }
+
+    // Writes what was recorded so far, main thread only
+    void stop() {
+        if(!isRecording()) return;
+
+        m_recording.store(false, std::memory_order_relaxed);
+        write();
+    }
+
+    bool isRecording() const { return m_recording.load(std::memory_order_relaxed); }
+
+    // Frame boundary, main thread only
+    void nextFrame() {
+        int64_t time = now();
+
+        if(isRecording()) {
+            record(nullptr, "frame", m_frameStart, time);
+            m_capturedFrames++;
+            if(--m_remainingFrames == 0) stop();
+        }
+
+        if(m_pendingFrames > 0) {
+            // The first capture registers the main thread before any worker, as thread 0
+            getThreadBuffer();
+
+            std::lock_guard<std::mutex> lock(m_buffersMutex);
+            for(auto& buffer: m_buffers) {
+                buffer->events.resize(m_capacity);
+                buffer->count = 0;
+                buffer->dropped = 0;
+            }
+
+            m_remainingFrames = m_pendingFrames;
+            m_pendingFrames = 0;
+            m_capturedFrames = 0;
+            m_recording.store(true, std::memory_order_relaxed);
+        }
+
+        if(isRecording()) m_frameStart = now();
+    }
+
+    // Nanoseconds since the first use of the tracer
+    static int64_t now() {
+        static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+private:
+    struct Event {
+        const char*     name;
+        const char*     category;
+        int64_t         start;
+        int64_t         end;
+    };
+
+    struct ThreadBuffer {
+        std::vector<Event>  events;
+        std::size_t         count;
+        std::size_t         dropped;
+        std::size_t         thread;
+    };
+
+    Tracer(): m_recording(false), m_pendingFrames(0), m_remainingFrames(0), m_capacity(0), m_capturedFrames(0),
+              m_frameStart(0) { }
+
+    ~Tracer() { stop(); }
+
+    void record(const char* name, const char* category, int64_t start, int64_t end) {
+        ThreadBuffer& buffer = getThreadBuffer();
+        if(buffer.count >= buffer.events.size()) {
+            buffer.dropped++;
+            return;
+        }
+
+        buffer.events[buffer.count++] = Event{name, category, start, end};
+    }
+
+    ThreadBuffer& getThreadBuffer() {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if(buffer == nullptr) {
+            std::lock_guard<std::mutex> lock(m_buffersMutex);
+            m_buffers.emplace_back(new ThreadBuffer{std::vector<Event>(m_capacity), 0, 0, m_buffers.size()});
+            buffer = m_buffers.back().get();
+        }
+
+        return *buffer;
+    }
+
+    // Every thread is between frames here, so the buffers are only read.
+    // Frame events have no name, they are numbered in the order they were recorded.
+    void write() {
+        std::lock_guard<std::mutex> lock(m_buffersMutex);
+
+        FILE* file = std::fopen(m_fileName.c_str(), "w");
+        if(file == nullptr) {
+            std::printf("Can't write trace to %s\n", m_fileName.c_str());
+            return;
+        }
+
+        std::size_t events = 0, dropped = 0, frame = 0;
+        std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        for(auto& buffer: m_buffers) {
+            std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s %zu\"}},\n",
+                         buffer->thread, (buffer->thread == 0) ? "main" : "thread", buffer->thread);
+
+            for(auto i = 0u; i < buffer->count; ++i) {
+                const Event& event = buffer->events[i];
+                if(event.name == nullptr) {
+                    std::fprintf(file, "{\"name\":\"frame %zu\"", frame++);
+                } else {
+                    std::fprintf(file, "{\"name\":\"%s\"", event.name);
+                }
+
+                std::fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f},\n",
+                             event.category, buffer->thread, event.start / 1000.0, (event.end - event.start) / 1000.0);
+            }
+
+            events += buffer->count;
+            dropped += buffer->dropped;
+            buffer->events = std::vector<Event>();
+            buffer->count = 0;
+        }
+
+        // Trailing commas aren't allowed, the metadata event closes the array
+        std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"AI_Examples\"}}\n]}\n");
+        std::fclose(file);
+
+        std::printf("Trace of %zu frames written to %s: %zu events, %zu dropped\n", m_capturedFrames, m_fileName.c_str(),
+                    events, dropped);
+    }
+
+    std::atomic<bool>   m_recording;
+    std::size_t         m_pendingFrames;
+    std::size_t         m_remainingFrames;
+    std::size_t         m_capacity;
+    std::string         m_fileName;
+
+    std::size_t         m_capturedFrames;
+    int64_t             m_frameStart;
+
+    std::mutex          m_buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#ifdef AI_NO_TRACE
+#define TRACE_SCOPE(name, category)
+#else
+#define TRACE_SCOPE(name, category) Tracer::Scope TRACE_CONCAT(traceScope, __LINE__)(name, category)
+#endif
+
+#endif // TRACER_H_INCLUDED
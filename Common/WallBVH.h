@@ -0,0 +1,253 @@
+#ifndef WALLBVH_H_INCLUDED
+#define WALLBVH_H_INCLUDED
+
+#include <vector>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include "entt.hpp"
+
+#include "Common.h"
+#include "SegmentBatch.h"
+#include "Components/Components.h"
+
+/*
+ * Bounding volume hierarchy over Wall segments.
+ *
+ * Walls are mostly static, so the tree is built once and then only touched
+ * when walls change: constructing or destroying a Wall rebuilds the tree,
+ * registry.replace<Wall>() only refits bounds of the existing tree. Both are
+ * deferred until update() (WallBVHSystem calls it every tick), because entt
+ * notifies us before the component is actually removed.
+ *
+ * Nodes are stored in a flat array, children of an inner node are placed
+ * right after their parent (left) or at rightChild. Leaves reference a range
+ * of m_batch and are tested with the SIMD kernel (one register per leaf).
+ */
+class WallBVH {
+public:
+    struct RayHit {
+        float           distance;   // from the ray start
+        glm::vec2       point;
+        glm::vec2       normal;
+        entt::entity    wall;
+    };
+
+    WallBVH(): m_rebuildNeeded(true), m_refitNeeded(false) { }
+
+    void connect(entt::registry& registry) {
+        registry.on_construct<Wall>().connect<&WallBVH::onWallsChanged>(*this);
+        registry.on_destroy<Wall>().connect<&WallBVH::onWallsChanged>(*this);
+        registry.on_replace<Wall>().connect<&WallBVH::onWallReplaced>(*this);
+    }
+
+    void disconnect(entt::registry& registry) {
+        registry.on_construct<Wall>().disconnect<&WallBVH::onWallsChanged>(*this);
+        registry.on_destroy<Wall>().disconnect<&WallBVH::onWallsChanged>(*this);
+        registry.on_replace<Wall>().disconnect<&WallBVH::onWallReplaced>(*this);
+    }
+
+    void update(entt::registry& registry) {
+        if(m_rebuildNeeded) {
+            rebuild(registry);
+        } else if(m_refitNeeded) {
+            refit(registry);
+        }
+    }
+
+    void rebuild(entt::registry& registry) {
+        m_segments.clear();
+        m_nodes.clear();
+
+        auto wallsView = registry.view<Wall>();
+        wallsView.each([&](entt::entity entity, Wall& wall) {
+            m_segments.push_back(WallSegment{wall.line, wall.normal, entity});
+        });
+
+        if(!m_segments.empty()) {
+            m_nodes.reserve(m_segments.size() * 2);
+            buildNode(0, m_segments.size());
+        }
+
+        fillBatch();
+
+        m_rebuildNeeded = false;
+        m_refitNeeded = false;
+    }
+
+    void refit(entt::registry& registry) {
+        for(auto& segment: m_segments) {
+            const Wall& wall = registry.get<Wall>(segment.wall);
+            segment.line = wall.line;
+            segment.normal = wall.normal;
+        }
+
+        fillBatch();
+
+        // Children always have greater indices than their parent
+        for(auto i = m_nodes.size(); i-- > 0;) {
+            Node& node = m_nodes[i];
+            if(node.count > 0) {
+                calculateBounds(node, node.first, node.first + node.count);
+            } else {
+                const Node& left = m_nodes[i + 1];
+                const Node& right = m_nodes[node.rightChild];
+                node.min = glm::min(left.min, right.min);
+                node.max = glm::max(left.max, right.max);
+            }
+        }
+
+        m_refitNeeded = false;
+    }
+
+    // Closest intersection of the segment ray.start -> ray.end with any wall
+    bool rayCast(const Line2D& ray, RayHit& hit) const {
+        if(m_nodes.empty()) return false;
+
+        glm::vec2 direction = ray.end - ray.start;
+        glm::vec2 invDirection = glm::vec2(1.0f / direction.x, 1.0f / direction.y);
+        float rayLength = glm::length(direction);
+
+        bool found = false;
+        float closestDistance = 0.0f;
+
+        std::size_t stack[64];
+        std::size_t stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while(stackSize > 0) {
+            const Node& node = m_nodes[stack[--stackSize]];
+
+            float entry;
+            if(!intersectBounds(node, ray.start, invDirection, entry)) continue;
+            if(found && entry * rayLength > closestDistance) continue;
+
+            if(node.count > 0) {
+                SegmentHit segmentHit;
+                if(rayCastSegments(m_batch, node.first, node.first + node.count, ray, segmentHit) &&
+                   (!found || segmentHit.distance < closestDistance)) {
+                    found = true;
+                    closestDistance = segmentHit.distance;
+
+                    hit.distance = segmentHit.distance;
+                    hit.point = segmentHit.point;
+                    hit.normal = segmentHit.normal;
+                    hit.wall = m_segments[segmentHit.index].wall;
+                }
+            } else {
+                stack[stackSize++] = node.rightChild;
+                stack[stackSize++] = &node - m_nodes.data() + 1;
+            }
+        }
+
+        return found;
+    }
+
+    std::size_t size() const { return m_segments.size(); }
+
+private:
+    static constexpr std::size_t MAX_LEAF_SIZE = (SEGMENT_BATCH_WIDTH > 4) ? SEGMENT_BATCH_WIDTH : 4;
+
+    struct WallSegment {
+        Line2D          line;
+        glm::vec2       normal;
+        entt::entity    wall;
+    };
+
+    struct Node {
+        glm::vec2       min;
+        glm::vec2       max;
+        std::size_t     first;          // leaves only
+        std::size_t     count;          // 0 for inner nodes
+        std::size_t     rightChild;     // inner nodes only
+    };
+
+    void onWallsChanged(entt::registry&, entt::entity) {
+        m_rebuildNeeded = true;
+    }
+
+    void onWallReplaced(entt::registry&, entt::entity) {
+        m_refitNeeded = true;
+    }
+
+    void calculateBounds(Node& node, std::size_t first, std::size_t last) const {
+        node.min = glm::min(m_segments[first].line.start, m_segments[first].line.end);
+        node.max = glm::max(m_segments[first].line.start, m_segments[first].line.end);
+        for(auto i = first + 1; i < last; ++i) {
+            node.min = glm::min(node.min, glm::min(m_segments[i].line.start, m_segments[i].line.end));
+            node.max = glm::max(node.max, glm::max(m_segments[i].line.start, m_segments[i].line.end));
+        }
+    }
+
+    // Top-down median split along the longest axis of segment centers
+    std::size_t buildNode(std::size_t first, std::size_t last) {
+        std::size_t index = m_nodes.size();
+        m_nodes.push_back(Node{});
+        calculateBounds(m_nodes[index], first, last);
+
+        if(last - first <= MAX_LEAF_SIZE) {
+            m_nodes[index].first = first;
+            m_nodes[index].count = last - first;
+            return index;
+        }
+
+        glm::vec2 centersMin = center(m_segments[first]), centersMax = centersMin;
+        for(auto i = first + 1; i < last; ++i) {
+            centersMin = glm::min(centersMin, center(m_segments[i]));
+            centersMax = glm::max(centersMax, center(m_segments[i]));
+        }
+
+        int axis = (centersMax.x - centersMin.x >= centersMax.y - centersMin.y) ? 0 : 1;
+        std::size_t middle = first + (last - first) / 2;
+        std::nth_element(m_segments.begin() + first, m_segments.begin() + middle, m_segments.begin() + last,
+                         [axis](const WallSegment& a, const WallSegment& b) {
+                             return center(a)[axis] < center(b)[axis];
+                         });
+
+        buildNode(first, middle);
+        std::size_t right = buildNode(middle, last);
+
+        m_nodes[index].count = 0;
+        m_nodes[index].rightChild = right;
+
+        return index;
+    }
+
+    void fillBatch() {
+        m_batch.resize(m_segments.size());
+        for(auto i = 0u; i < m_segments.size(); ++i) {
+            m_batch.set(i, m_segments[i].line, m_segments[i].normal);
+        }
+    }
+
+    static glm::vec2 center(const WallSegment& segment) {
+        return (segment.line.start + segment.line.end) * 0.5f;
+    }
+
+    // Slab test, entry is a ray parameter in [0, 1] where the ray enters the box
+    static bool intersectBounds(const Node& node, glm::vec2 origin, glm::vec2 invDirection, float& entry) {
+        float tmin = 0.0f, tmax = 1.0f;
+        for(int axis = 0; axis < 2; ++axis) {
+            float t1 = (node.min[axis] - origin[axis]) * invDirection[axis];
+            float t2 = (node.max[axis] - origin[axis]) * invDirection[axis];
+
+            // Ray parallel to the slab and its origin lies on the slab border (0 * inf)
+            if(std::isnan(t1) || std::isnan(t2)) continue;
+
+            tmin = std::max(tmin, std::min(t1, t2));
+            tmax = std::min(tmax, std::max(t1, t2));
+        }
+
+        entry = tmin;
+        return tmin <= tmax;
+    }
+
+    std::vector<WallSegment>    m_segments;
+    SegmentBatch                m_batch;
+    std::vector<Node>           m_nodes;
+
+    bool                        m_rebuildNeeded;
+    bool                        m_refitNeeded;
+};
+
+#endif // WALLBVH_H_INCLUDED
@@ -1,6 +1,8 @@
 #include "helper.h"
+#include "Components/Components.h"
 
 #include <iostream>
+#include <cmath>
 glm::vec2 calculatePerp(glm::vec2 vec) {
     return glm::vec2(-vec.y, vec.x);
 }
@@ -27,32 +29,14 @@ void drawCircle(SDL_Renderer* renderer, glm::vec2 position, float radius, SDL_Co
 }
 
 glm::vec2 convertToLocal(glm::vec2 ownerHeadingVec, glm::vec2 ownerPos, glm::vec2 targetPos) {
-    glm::vec2 head = glm::normalize(ownerHeadingVec);
-    glm::vec2 perp = glm::normalize(calculatePerp(ownerHeadingVec));
-    glm::vec2 result = targetPos - ownerPos;
-
-    // Unoptimized way!
-    glm::mat2x2 mat;
-    mat[0][0] = head.x; mat[0][1] = head.y;
-    mat[1][0] = perp.x; mat[1][1] = perp.y;
-
-    mat = glm::inverse(mat);
-
-    return mat * result;
+    return LocalFrame(glm::normalize(ownerHeadingVec)).toLocal(ownerPos, targetPos);
 }
 
-
 glm::vec2 convertToWorld(glm::vec2 ownerHeadingVec, glm::vec2 ownerPos, glm::vec2 targetPos) {
-    glm::vec2 head = glm::normalize(ownerHeadingVec);
-    glm::vec2 side = glm::normalize(calculatePerp(ownerHeadingVec));
-
-    // Affine transform
-    glm::vec2 result = head * targetPos.x + side * targetPos.y + ownerPos;
-
-    return result;
+    return LocalFrame(glm::normalize(ownerHeadingVec)).toWorld(ownerPos, targetPos);
 }
 
-bool testLineIntersection2D(Line2D lineA, Line2D lineB, IntersectionResult& result) {
+bool testLineIntersection2D(const Line2D& lineA, const Line2D& lineB, IntersectionResult& result) {
     glm::vec2 d1 = lineA.end - lineA.start;
     glm::vec2 d2 = lineB.end - lineB.start;
     glm::vec2 r  = lineA.start - lineB.start;
@@ -62,7 +46,7 @@ bool testLineIntersection2D(Line2D lineA, Line2D lineB, IntersectionResult& resu
     float e = glm::dot(d2, d2);
 
     float d = a * e - b * b;
-    if(abs(d) < 0.001) {
+    if(std::fabs(d) < 0.001f) {
         return false;
     }
 
@@ -20,6 +20,6 @@ struct IntersectionResult {
     Point point;
 };
 
-bool testLineIntersection2D(Line2D lineA, Line2D lineB, IntersectionResult& result);
+bool testLineIntersection2D(const Line2D& lineA, const Line2D& lineB, IntersectionResult& result);
 
 #endif // HELPER_H_INCLUDED
@@ -22,18 +22,41 @@
  * So in general we have an interface for translating coordinates to 1-D path`s
  * coordinates or vice versa. That's all!
  *
+ * An agent moves only a few pixels per tick, so it may keep a PathCursor
+ * (as a component) and pass it to getParam: paths which support it search
+ * near the last result only.
+ *
  */
+class IPath;
+
+struct PathCursor {
+    PathCursor(): path(nullptr), segment(0), param(0.0f) { }
+
+    const IPath*    path;       // cursor is reset when the agent switches paths
+    std::size_t     segment;
+    float           param;
+};
+
 class IPath {
 public:
     virtual float getParam(glm::vec2 position) const = 0;
     virtual glm::vec2 getPosition(float param) const = 0;
 
+    virtual float getParam(glm::vec2 position, PathCursor& cursor) const {
+        cursor.path = this;
+        cursor.param = getParam(position);
+        return cursor.param;
+    }
+
     virtual std::vector<glm::vec2> generateVertices() const {
         return std::vector<glm::vec2>{};
     }
 };
 
 #include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
 
 struct Segment {
 
@@ -68,44 +91,121 @@ struct Segment {
     glm::vec2 end;
 };
 
+/*
+ * setPath() precomputes everything queries need: cumulative arc length at the
+ * start of each segment (m_cumulativeLengths[i], the last entry is the whole
+ * path length), normalized segment directions and inverse squared lengths for
+ * projections. So getParam() is a single pass without any sqrt per segment and
+ * getPosition() is a binary search.
+ *
+ * Paths with at least m_indexThreshold segments (road networks) also get a
+ * uniform grid of segment bounding boxes. The closest segment is then searched
+ * in rings of cells around the position, until the ring is further than the
+ * best distance so far. Ties go to the lowest index, exactly as in the linear
+ * scan, so both return the same segment.
+ */
 class SegmentedPath: public IPath {
 public:
+    SegmentedPath(): m_pathLength(0.0f), m_cursorStrayDistance(64.0f), m_indexThreshold(256) { }
+
     float getParam(glm::vec2 position) const {
+        if(m_segments.empty()) return 0.0f;
 
-        auto closestSegmentIdx = 0u;
-        for(auto i = 0u; i < m_segments.size(); ++i) {
-            if(m_segments[i].getDistanceToPoint(position) <
-               m_segments[closestSegmentIdx].getDistanceToPoint(position)) {
-                closestSegmentIdx = i;
+        float distance;
+        return getSegmentParam(findClosestSegment(position, distance), position);
+    }
+
+    // Searches CURSOR_WINDOW segments around the last closest one, then keeps going
+    // while the window edge is still the closest. Whole path is searched when the cursor
+    // is new or the agent is further than the stray distance from the found segment.
+    float getParam(glm::vec2 position, PathCursor& cursor) const {
+        if(m_segments.empty()) return 0.0f;
+
+        float distance = 0.0f;
+        std::size_t closest = 0;
+        bool found = false;
+
+        if(cursor.path == this && cursor.segment < m_segments.size()) {
+            std::size_t first = (cursor.segment > CURSOR_WINDOW) ? cursor.segment - CURSOR_WINDOW : 0;
+            std::size_t last = std::min(cursor.segment + CURSOR_WINDOW + 1, m_segments.size());
+            closest = findClosestSegment(position, first, last, distance);
+
+            while(closest == first && first > 0) {
+                float previousDistance = getSquaredDistance(first - 1, position);
+                if(previousDistance >= distance) break;
+
+                closest = --first;
+                distance = previousDistance;
             }
-        }
 
-        float t = 0.0f;
-        if(closestSegmentIdx > 0) {
-            for(auto i = 0u; i <= closestSegmentIdx - 1; i++) {
-                t += m_segments[i].length();
+            while(closest == last - 1 && last < m_segments.size()) {
+                float nextDistance = getSquaredDistance(last, position);
+                if(nextDistance >= distance) break;
+
+                closest = last++;
+                distance = nextDistance;
             }
+
+            found = distance <= m_cursorStrayDistance * m_cursorStrayDistance;
         }
 
-        t += glm::length(m_segments[closestSegmentIdx].getProjectedPoint(position) - m_segments[closestSegmentIdx].start);
+        if(!found) {
+            closest = findClosestSegment(position, distance);
+        }
+
+        cursor.path = this;
+        cursor.segment = closest;
+        cursor.param = getSegmentParam(closest, position);
 
-        return t;
+        return cursor.param;
     }
 
     glm::vec2 getPosition(float param) const {
-        auto segmentIndex = 0u;
-        while(param > m_segments[segmentIndex].length()) {
-            param -= m_segments[segmentIndex].length();
-            segmentIndex++;
-        }
+        if(m_segments.empty() || param > m_pathLength) return glm::vec2(0.0f, 0.0f);
 
-        if(segmentIndex >= m_segments.size()) return glm::vec2(0.0f, 0.0f);
+        // First segment whose end is not before the param
+        auto segmentEnd = std::lower_bound(m_cumulativeLengths.begin() + 1, m_cumulativeLengths.end(), param);
+        auto segmentIndex = std::size_t(segmentEnd - m_cumulativeLengths.begin()) - 1;
 
-        return m_segments[segmentIndex].start + m_segments[segmentIndex].direction() * param;
+        return m_segments[segmentIndex].start + m_directions[segmentIndex] * (param - m_cumulativeLengths[segmentIndex]);
     }
 
     void setPath(std::vector<Segment> segments) {
-        m_segments = segments;
+        m_segments = std::move(segments);
+
+        m_cumulativeLengths.resize(m_segments.size() + 1);
+        m_directions.resize(m_segments.size());
+        m_invSquaredLengths.resize(m_segments.size());
+
+        m_cumulativeLengths[0] = 0.0f;
+        for(auto i = 0u; i < m_segments.size(); ++i) {
+            float length = m_segments[i].length();
+
+            m_cumulativeLengths[i + 1] = m_cumulativeLengths[i] + length;
+            m_directions[i] = (length > 0.0f) ? (m_segments[i].end - m_segments[i].start) / length : glm::vec2(0.0f, 0.0f);
+            m_invSquaredLengths[i] = (length > 0.0f) ? 1.0f / (length * length) : 0.0f;
+        }
+
+        m_pathLength = m_cumulativeLengths.back();
+
+        buildIndex();
+    }
+
+    float getPathLength() const {
+        return m_pathLength;
+    }
+
+    void setCursorStrayDistance(float distance) {
+        m_cursorStrayDistance = distance;
+    }
+
+    // Takes effect on the next setPath()
+    void setIndexThreshold(std::size_t segmentsCount) {
+        m_indexThreshold = segmentsCount;
+    }
+
+    bool hasIndex() const {
+        return !m_indexCellStart.empty();
     }
 
     std::vector<glm::vec2> generateVertices() const {
@@ -123,42 +223,196 @@ public:
     }
 
 private:
-    std::vector<Segment> m_segments;
-    float m_pathLength;
+    static constexpr std::size_t CURSOR_WINDOW = 2;
+
+    void buildIndex() {
+        m_indexCellStart.clear();
+        m_indexSegments.clear();
+        if(m_segments.empty() || m_segments.size() < m_indexThreshold) return;
+
+        glm::vec2 min = glm::min(m_segments[0].start, m_segments[0].end), max = min;
+        for(const auto& segment: m_segments) {
+            min = glm::min(min, glm::min(segment.start, segment.end));
+            max = glm::max(max, glm::max(segment.start, segment.end));
+        }
+
+        // Roughly one segment per cell, but never smaller than an average segment
+        glm::vec2 size = glm::max(max - min, glm::vec2(1.0f, 1.0f));
+        m_indexCellSize = std::max(std::sqrt(size.x * size.y / float(m_segments.size())),
+                                   m_pathLength / float(m_segments.size()));
+        m_indexOrigin = min;
+        m_indexWidth = int(size.x / m_indexCellSize) + 1;
+        m_indexHeight = int(size.y / m_indexCellSize) + 1;
+
+        // Counting sort of (cell, segment) pairs: count, prefix sum, fill
+        m_indexCellStart.assign(std::size_t(m_indexWidth) * m_indexHeight + 1, 0);
+        forEachSegmentCell([&](std::size_t cell, std::size_t) { m_indexCellStart[cell + 1]++; });
+
+        for(auto i = 1u; i < m_indexCellStart.size(); ++i) {
+            m_indexCellStart[i] += m_indexCellStart[i - 1];
+        }
+
+        std::vector<std::uint32_t> fill(m_indexCellStart.begin(), m_indexCellStart.end() - 1);
+        m_indexSegments.resize(m_indexCellStart.back());
+        forEachSegmentCell([&](std::size_t cell, std::size_t segment) { m_indexSegments[fill[cell]++] = segment; });
+    }
+
+    template<typename Callback>
+    void forEachSegmentCell(Callback callback) const {
+        for(auto i = 0u; i < m_segments.size(); ++i) {
+            glm::ivec2 first = getIndexCell(glm::min(m_segments[i].start, m_segments[i].end));
+            glm::ivec2 last = getIndexCell(glm::max(m_segments[i].start, m_segments[i].end));
+
+            for(int y = first.y; y <= last.y; ++y) {
+                for(int x = first.x; x <= last.x; ++x) {
+                    callback(std::size_t(y) * m_indexWidth + x, i);
+                }
+            }
+        }
+    }
+
+    glm::ivec2 getIndexCell(glm::vec2 position) const {
+        glm::vec2 cell = glm::floor((position - m_indexOrigin) / m_indexCellSize);
+        return glm::ivec2(glm::clamp(int(cell.x), 0, m_indexWidth - 1), glm::clamp(int(cell.y), 0, m_indexHeight - 1));
+    }
+
+    // Whole path, through the index if there is one
+    std::size_t findClosestSegment(glm::vec2 position, float& distance) const {
+        if(!hasIndex()) {
+            return findClosestSegment(position, 0, m_segments.size(), distance);
+        }
+
+        glm::ivec2 center = getIndexCell(position);
+        int maxRing = std::max(std::max(center.x, m_indexWidth - 1 - center.x),
+                               std::max(center.y, m_indexHeight - 1 - center.y));
+
+        std::size_t closest = m_segments.size();
+        distance = 0.0f;
+
+        auto visitCell = [&](int x, int y) {
+            if(x < 0 || y < 0 || x >= m_indexWidth || y >= m_indexHeight) return;
+
+            std::size_t cell = std::size_t(y) * m_indexWidth + x;
+            for(auto i = m_indexCellStart[cell]; i < m_indexCellStart[cell + 1]; ++i) {
+                std::size_t segment = m_indexSegments[i];
+                float segmentDistance = getSquaredDistance(segment, position);
+                if(closest == m_segments.size() || segmentDistance < distance ||
+                   (segmentDistance == distance && segment < closest)) {
+                    closest = segment;
+                    distance = segmentDistance;
+                }
+            }
+        };
+
+        for(int ring = 0; ring <= maxRing; ++ring) {
+            // Anything in this ring is at least (ring - 1) cells away, even for positions outside of the grid
+            float bound = std::max(0.0f, (ring - 1.0f) * m_indexCellSize * 0.999f);
+            if(closest != m_segments.size() && bound * bound > distance) break;
+
+            if(ring == 0) {
+                visitCell(center.x, center.y);
+                continue;
+            }
+
+            for(int x = center.x - ring; x <= center.x + ring; ++x) {
+                visitCell(x, center.y - ring);
+                visitCell(x, center.y + ring);
+            }
+
+            for(int y = center.y - ring + 1; y <= center.y + ring - 1; ++y) {
+                visitCell(center.x - ring, y);
+                visitCell(center.x + ring, y);
+            }
+        }
+
+        return closest;
+    }
+
+    // Closest segment in [first, last), the first one on ties. Distance is squared.
+    std::size_t findClosestSegment(glm::vec2 position, std::size_t first, std::size_t last, float& distance) const {
+        std::size_t closest = first;
+        distance = getSquaredDistance(first, position);
+        for(auto i = first + 1; i < last; ++i) {
+            float segmentDistance = getSquaredDistance(i, position);
+            if(segmentDistance < distance) {
+                closest = i;
+                distance = segmentDistance;
+            }
+        }
+
+        return closest;
+    }
+
+    float getSquaredDistance(std::size_t index, glm::vec2 position) const {
+        glm::vec2 offset = position - getProjectedPoint(index, position);
+        return glm::dot(offset, offset);
+    }
+
+    float getSegmentParam(std::size_t index, glm::vec2 position) const {
+        return m_cumulativeLengths[index] + glm::length(getProjectedPoint(index, position) - m_segments[index].start);
+    }
+
+    // Like Segment::getProjectedPoint, but without recomputing the length and clamped to the segment:
+    // distances to infinite lines let the neighbouring segments win at every corner
+    glm::vec2 getProjectedPoint(std::size_t index, glm::vec2 worldPosition) const {
+        const Segment& segment = m_segments[index];
+        glm::vec2 delta = segment.end - segment.start;
+
+        float t = glm::dot(worldPosition - segment.start, delta) * m_invSquaredLengths[index];
+        return segment.start + glm::clamp(t, 0.0f, 1.0f) * delta;
+    }
+
+    std::vector<Segment>    m_segments;
+    std::vector<float>      m_cumulativeLengths;
+    std::vector<glm::vec2>  m_directions;
+    std::vector<float>      m_invSquaredLengths;
+    float                   m_pathLength;
+    float                   m_cursorStrayDistance;
+
+    std::size_t                 m_indexThreshold;
+    std::vector<std::uint32_t>  m_indexCellStart;   // cell -> first entry in m_indexSegments
+    std::vector<std::uint32_t>  m_indexSegments;
+    glm::vec2                   m_indexOrigin;
+    float                       m_indexCellSize;
+    int                         m_indexWidth;
+    int                         m_indexHeight;
 };
 
 using Waypoints = std::vector<glm::vec2>;
 
+// followPath() state of an agent (a component): its position on the waypoints. Copies share the waypoints.
 class WaypointsPath {
 public:
-    WaypointsPath(): m_threshold(0.0f), m_looped(false) { }
-    WaypointsPath(const Waypoints& waypoints, float threshold, bool looped): m_waypoints(waypoints),
-                                                                             m_currentWaypoint(0),
-                                                                             m_threshold(threshold),
-                                                                             m_looped(looped) { }
+    WaypointsPath(): m_currentWaypoint(0), m_threshold(0.0f), m_looped(false) { }
+    WaypointsPath(const Waypoints& waypoints, float threshold, bool looped):
+        WaypointsPath(std::make_shared<const Waypoints>(waypoints), threshold, looped) { }
+    WaypointsPath(std::shared_ptr<const Waypoints> waypoints, float threshold, bool looped): m_waypoints(waypoints),
+                                                                                             m_currentWaypoint(0),
+                                                                                             m_threshold(threshold),
+                                                                                             m_looped(looped) { }
 
     glm::vec2 getCurrentWaypoint() const {
 
-        return (m_waypoints.empty()) ? glm::vec2(0.0f, 0.0f) : m_waypoints[m_currentWaypoint];
+        return (isEmpty()) ? glm::vec2(0.0f, 0.0f) : (*m_waypoints)[m_currentWaypoint];
     }
 
     glm::vec2 nextWaypoint() {
-        if(m_currentWaypoint < m_waypoints.size() - 1) {
+        if(m_currentWaypoint < m_waypoints->size() - 1) {
             m_currentWaypoint++;
         } else if(m_looped) {
             m_currentWaypoint = 0;
         }
 
-        return m_waypoints[m_currentWaypoint];
+        return (*m_waypoints)[m_currentWaypoint];
     }
 
     bool isFinished() const {
 
-        return (m_waypoints.empty() || (m_currentWaypoint == m_waypoints.size() - 1 && !m_looped));
+        return (isEmpty() || (m_currentWaypoint == m_waypoints->size() - 1 && !m_looped));
     }
 
     void setWaypoints(const Waypoints& waypoints) {
-        m_waypoints = waypoints;
+        m_waypoints = std::make_shared<const Waypoints>(waypoints);
     }
 
     void setThreshold(float threshold) {
@@ -172,10 +426,12 @@ public:
 
 
 private:
-    Waypoints       m_waypoints;
-    std::size_t     m_currentWaypoint;
-    float           m_threshold;
-    bool            m_looped;
+    bool isEmpty() const { return !m_waypoints || m_waypoints->empty(); }
+
+    std::shared_ptr<const Waypoints>    m_waypoints;
+    std::size_t                         m_currentWaypoint;
+    float                               m_threshold;
+    bool                                m_looped;
 
 };
 
@@ -5,22 +5,91 @@
 #include <iostream>
 
 #include "helper.h"
+#include "SpatialHashGrid.h"
+#include "WallBVH.h"
+#include "SegmentBatch.h"
+#include "Tracer.h"
+#include "SteeringKernels.h"
+#include "SteeringPipeline.h"
 #include <cmath>
+#include <array>
 
 SteeringManager::SteeringManager(entt::registry* registry, entt::entity owner): m_registry(registry),
                                                                                 m_owner(owner),
-                                                                                m_wanderLastOrientation(0.0f, 0.0f) { }
+                                                                                m_avoidedObstacle(entt::null) {
+}
 
 glm::vec2 SteeringManager::calculate() {
-    //if seek_on / if arrive_on / if evade_on ...
+    const AI& ai = m_registry->get<AI>(m_owner);
+    const SteeringSettings& settings = ai.settings;
+
+    // Components looked up once for the behaviours which take the context
+    SteeringContext context(*m_registry, m_owner, ai.target);
+
+    float maxForce = context.physics.maxForce;
     glm::vec2 totalForce = glm::vec2(0.0f, 0.0f);
-    totalForce += 0.7f * obstacleAvoiding2() + 0.3f * offsetPursuit(target, glm::vec2(-48.0f, -48.0f));
-//    totalForce += wallAvoidance();
-//    totalForce += obstacleAvoiding2();
-//    if(glm::length(totalForce) < 0.1f)
-//        totalForce += wander() * 0.2f;
 
-    return totalForce;
+    for(int i = 0; i < SteeringSettings::BEHAVIOURS_COUNT; ++i) {
+        auto behaviour = SteeringSettings::Behaviour(i);
+        if(!settings.isEnabled(behaviour)) {
+            continue;
+        }
+
+        if(settings.mode == SteeringSettings::PRIORITISED) {
+            // Budget spent: lower priority behaviours aren't evaluated
+            if(glm::length(totalForce) >= maxForce - MINIMAL_SPEED) {
+                break;
+            }
+
+            accumulateForce(totalForce, evaluate(behaviour, settings, context) * settings.weights[i], maxForce);
+        } else {
+            totalForce += evaluate(behaviour, settings, context) * settings.weights[i];
+        }
+    }
+
+    m_avoidedObstacle = context.avoidedObstacle;
+    return wrapVector(totalForce, maxForce);
+}
+
+glm::vec2 SteeringManager::evaluate(SteeringSettings::Behaviour behaviour, const SteeringSettings& settings,
+                                    SteeringContext& context) {
+    // Nothing to chase, flee from or hide from while the target is unset or gone
+    if(SteeringSettings::followsTarget(behaviour) && !m_registry->valid(context.target)) {
+        return glm::vec2(0.0f, 0.0f);
+    }
+
+    switch(behaviour) {
+    case SteeringSettings::WALL_AVOIDANCE:      return sp::wallAvoidance(context);
+    case SteeringSettings::OBSTACLE_AVOIDANCE:  return sp::obstacleAvoidance(context);
+    case SteeringSettings::EVADE:               return evade(context.target);
+    case SteeringSettings::FLEE:                return flee(settings.targetPosition);
+    case SteeringSettings::SEEK:                return seek(settings.targetPosition);
+    case SteeringSettings::ARRIVE:              return arrive(settings.targetPosition, Deceleration(settings.deceleration));
+    case SteeringSettings::PURSUIT:             return pursuit(context.target);
+    case SteeringSettings::OFFSET_PURSUIT:      return sp::offsetPursuit(context, settings.offset);
+    case SteeringSettings::INTERPOSE:
+        // The second target can be unset or gone too
+        if(!m_registry->valid(settings.secondTarget)) {
+            return glm::vec2(0.0f, 0.0f);
+        }
+        return interpose(context.target, settings.secondTarget);
+    case SteeringSettings::FOLLOW_PATH:         return sp::followPath(context);
+    case SteeringSettings::HIDE:                return sp::hide(context);
+    case SteeringSettings::WANDER:              return sp::wander(context);
+    default:                                    return glm::vec2(0.0f, 0.0f);
+    }
+}
+
+bool accumulateForce(glm::vec2& totalForce, glm::vec2 force, float maxForce) {
+    float remaining = maxForce - glm::length(totalForce);
+    if(remaining <= 0.0f) {
+        return false;
+    }
+
+    float length = glm::length(force);
+    totalForce += (length < remaining) ? force : force * (remaining / length);
+
+    return true;
 }
 
 //Strategy pattern? i.e for each behavior its own class
@@ -28,21 +97,14 @@ glm::vec2 SteeringManager::seek(glm::vec2 target) {
     auto& transformComponent = m_registry->get<Transform>(m_owner);
     auto& physicsComponent = m_registry->get<Physics>(m_owner);
 
-    glm::vec2 desiredVelocity = safeNormalize(target - transformComponent.position) * physicsComponent.maxSpeed;
-    return desiredVelocity - physicsComponent.velocity;
+    return sk::seek(transformComponent.position, physicsComponent.velocity, physicsComponent.maxSpeed, target);
 }
 
 glm::vec2 SteeringManager::flee(glm::vec2 target) {
     auto& transformComponent = m_registry->get<Transform>(m_owner);
     auto& physicsComponent = m_registry->get<Physics>(m_owner);
 
-    float distance = glm::distance(transformComponent.position, target);
-    if(distance > 300.0f) {
-        return glm::vec2(0.0f, 0.0f); //No force required
-    }
-
-    glm::vec2 desiredVelocity = physicsComponent.maxSpeed * (transformComponent.position - target) / distance;
-    return desiredVelocity - physicsComponent.velocity;
+    return sk::flee(transformComponent.position, physicsComponent.velocity, physicsComponent.maxSpeed, target);
 }
 
 
@@ -51,14 +113,7 @@ glm::vec2 SteeringManager::arrive(glm::vec2 target,
     auto& transformComponent = m_registry->get<Transform>(m_owner);
     auto& physicsComponent = m_registry->get<Physics>(m_owner);
 
-    glm::vec2 direction = target - transformComponent.position;
-    float distance = glm::distance(transformComponent.position, target);
-    float dec = 0.3f * int(deceleration);
-
-    float speed = distance / dec;
-
-    glm::vec2 desiredVelocity = (direction / distance) * speed;
-    return desiredVelocity - physicsComponent.velocity;
+    return sk::arrive(transformComponent.position, physicsComponent.velocity, target, int(deceleration));
 }
 
 glm::vec2 SteeringManager::pursuit(entt::entity target) {
@@ -68,32 +123,9 @@ glm::vec2 SteeringManager::pursuit(entt::entity target) {
     auto& physicsComponent = m_registry->get<Physics>(m_owner);
     auto& targetPhysicsComponent = m_registry->get<Physics>(target);
 
-    glm::vec2 direction = targetTransformComponent.position - transformComponent.position;
-
-    //Angle between target's and owner's heading vectors
-    float relativeHeading = glm::dot(orientationToVec(transformComponent.angle),
-                                     orientationToVec(targetTransformComponent.angle));
-
-    //Angle between owner's heading and direction vectors
-    float relativeMovingDirection = glm::dot(orientationToVec(transformComponent.angle),
-                                             safeNormalize(direction));
-
-    //If angle between target and owner heading vectors lower than 18 degs
-    //and owner heading towards direction
-    if(relativeHeading > 0.95f && relativeMovingDirection > 0.0f) {
-        return seek(targetTransformComponent.position);
-    }
-
-
-    float distance = glm::length(direction);
-    float totalSpeed = glm::length(physicsComponent.velocity) + glm::length(targetPhysicsComponent.velocity);
-    float predictTime = 0.0f;
-
-    if(totalSpeed > MINIMAL_SPEED) {
-        predictTime = distance / totalSpeed;
-    }
-
-    return seek(targetTransformComponent.position + targetPhysicsComponent.velocity * predictTime);
+    return sk::pursuit(transformComponent.position, physicsComponent.velocity, orientationToVec(transformComponent.angle),
+                       physicsComponent.maxSpeed, targetTransformComponent.position, targetPhysicsComponent.velocity,
+                       orientationToVec(targetTransformComponent.angle));
 }
 
 glm::vec2 SteeringManager::evade(entt::entity target) {
@@ -103,17 +135,21 @@ glm::vec2 SteeringManager::evade(entt::entity target) {
     auto& physicsComponent = m_registry->get<Physics>(m_owner);
     auto& targetPhysicsComponent = m_registry->get<Physics>(target);
 
-    float distance = glm::distance(transformComponent.position, targetTransformComponent.position);
-    float totalSpeed = glm::length(targetPhysicsComponent.velocity) + glm::length(physicsComponent.velocity);
-
-    float predictTime = 0.0f;
-    if(totalSpeed > MINIMAL_SPEED)
-        predictTime = distance / totalSpeed;
-
-    return flee(targetTransformComponent.position + targetPhysicsComponent.velocity * predictTime);
+    return sk::evade(transformComponent.position, physicsComponent.velocity, physicsComponent.maxSpeed,
+                     targetTransformComponent.position, targetPhysicsComponent.velocity);
 }
 
 glm::vec2 SteeringManager::wander() {
+    SteeringContext context(*m_registry, m_owner, entt::null);
+    return sp::wander(context);
+}
+
+glm::vec2 sp::wander(SteeringContext& context) {
+    WanderState* state = context.registry.try_get<WanderState>(context.owner);
+    if(state == nullptr) {
+        return glm::vec2(0.0f, 0.0f);
+    }
+
     //TODO: Get/Set wander parameters
     static float wanderOffset = 50.0f;
     static float wanderRadius = 10.0f;
@@ -124,32 +160,36 @@ glm::vec2 SteeringManager::wander() {
     //wanderOffset = (std::sin(SDL_GetTicks() / 1000.0f) + 1.0f) * 0.5f * 40.0f + 10.0f;
     //wanderMaxLength = (std::sin(SDL_GetTicks() / 5000.0f) + 1.0f) * 5.0f;
 
-    auto& transformComponent = m_registry->get<Transform>(m_owner);
-    auto& physicsComponent = m_registry->get<Physics>(m_owner);
-
-    glm::vec2 randDirection = glm::vec2(drand48() - drand48(), drand48() - drand48());
+    glm::vec2 randDirection = glm::vec2(erand48(state->randomState) - erand48(state->randomState),
+                                        erand48(state->randomState) - erand48(state->randomState));
     randDirection = safeNormalize(randDirection) * wanderMaxLength;
 
-    m_wanderLastOrientation = safeNormalize(m_wanderLastOrientation + randDirection) * wanderRadius;
-    //std::cout << m_wanderLastOrientation.x << " " << m_wanderLastOrientation.y << std::endl;
+    state->orientation = safeNormalize(state->orientation + randDirection) * wanderRadius;
 
-    glm::vec2 targetPosition = transformComponent.position +
-                               safeNormalize(physicsComponent.velocity) * wanderOffset +
-                               m_wanderLastOrientation;
-    return seek(targetPosition);
+    glm::vec2 targetPosition = context.transform.position +
+                               safeNormalize(context.physics.velocity) * wanderOffset +
+                               state->orientation;
+    return sk::seek(context.transform.position, context.physics.velocity, context.physics.maxSpeed, targetPosition);
 }
 
 
 glm::vec2 SteeringManager::obstacleAvoiding2() {
-    Transform& transform = m_registry->get<Transform>(m_owner);
-    Physics& physics = m_registry->get<Physics>(m_owner);
-
-    glm::vec2 head = safeNormalize(physics.velocity);
+    SteeringContext context(*m_registry, m_owner, entt::null);
+    glm::vec2 force = sp::obstacleAvoidance(context);
 
-    if(head.x * head.x + head.y * head.y < 0.01f) {
-        head = orientationToVec(transform.angle);
+    if(context.avoidedObstacle != entt::null) {
+        m_avoidedObstacle = context.avoidedObstacle;
     }
 
+    return force;
+}
+
+glm::vec2 sp::obstacleAvoidance(SteeringContext& context) {
+    TRACE_SCOPE("obstacleAvoiding2", "behaviour");
+
+    const Transform& transform = context.transform;
+    const Physics& physics = context.physics;
+    const LocalFrame& frame = context.frame;
 
     float minBoxLength = 100.0f;
     float boxLength = minBoxLength + physics.velocity.length() / physics.maxSpeed * minBoxLength;
@@ -158,14 +198,13 @@ glm::vec2 SteeringManager::obstacleAvoiding2() {
     entt::entity closestObstacle = entt::null;
     float closestDistance = 0.0f;
 
-    auto obstaclesView = m_registry->view<Transform, Physics, Obstacle>();
-    obstaclesView.each([&](entt::entity obstacle, Transform& obTransform, Physics& obPhysics, Obstacle& obs) {
-        glm::vec2 obstacleLocalPos = convertToLocal(head, transform.position, obTransform.position);
-        if(obstacleLocalPos.x < 0.0f || obstacleLocalPos.x - obPhysics.radius >= boxLength) {
+    auto testObstacle = [&](entt::entity obstacle, glm::vec2 obstaclePosition, float obstacleRadius) {
+        glm::vec2 obstacleLocalPos = frame.toLocal(transform.position, obstaclePosition);
+        if(obstacleLocalPos.x < 0.0f || obstacleLocalPos.x - obstacleRadius >= boxLength) {
             return;
         }
 
-        float r = obPhysics.radius + physics.radius;
+        float r = obstacleRadius + physics.radius;
 
         if(r < std::fabs(obstacleLocalPos.y)) {
             return;
@@ -181,22 +220,46 @@ glm::vec2 SteeringManager::obstacleAvoiding2() {
             closestObstacle = obstacle;
             closestDistance = mn;
         }
-    });
+    };
+
+    if(const ObstacleGrid* grid = context.registry.try_ctx<ObstacleGrid>(); grid) {
+        // Only centers inside of the detection box can pass the test above, so we
+        // query world bounds of the box: [0, boxLength + maxRadius] x [-halfWidth, halfWidth]
+        float boxFront = boxLength + grid->getMaxRadius();
+        float halfWidth = physics.radius + grid->getMaxRadius();
+        glm::vec2 corners[4] = {
+            glm::vec2(0.0f, halfWidth), glm::vec2(0.0f, -halfWidth),
+            glm::vec2(boxFront, halfWidth), glm::vec2(boxFront, -halfWidth)
+        };
+        frame.toWorld(transform.position, corners, corners);
+
+        glm::vec2 min = corners[0], max = corners[0];
+        for(auto corner: corners) {
+            min = glm::min(min, corner);
+            max = glm::max(max, corner);
+        }
 
-    std::cout << closestDistance << "\n";
+        grid->queryRect(min, max, [&](const SpatialHashGrid::Item& item) {
+            testObstacle(item.entity, item.position, item.radius);
+        });
+    } else {
+        auto obstaclesView = context.registry.view<Transform, Physics, Obstacle>();
+        obstaclesView.each([&](entt::entity obstacle, Transform& obTransform, Physics& obPhysics, Obstacle& obs) {
+            testObstacle(obstacle, obTransform.position, obPhysics.radius);
+        });
+    }
 
     if(closestObstacle != entt::null) {
-        Transform& obTransform = m_registry->get<Transform>(closestObstacle);
-        Physics& obPhysics = m_registry->get<Physics>(closestObstacle);
-        Obstacle& obstacle = m_registry->get<Obstacle>(closestObstacle);
-        obstacle.color = SDL_Color {255, 0, 0 };
-        glm::vec2 obstacleLocalPos = convertToLocal(head, transform.position, obTransform.position);
+        Transform& obTransform = context.registry.get<Transform>(closestObstacle);
+        Physics& obPhysics = context.registry.get<Physics>(closestObstacle);
+        context.avoidedObstacle = closestObstacle;
+        glm::vec2 obstacleLocalPos = frame.toLocal(transform.position, obTransform.position);
 
         float mult = (1.0f - closestDistance / boxLength) + 1.0f;
         glm::vec2 lateral = glm::vec2(0, (obPhysics.radius - obstacleLocalPos.y) * mult * 10.0f);
         glm::vec2 braking = glm::vec2((obPhysics.radius - obstacleLocalPos.x) * 10.0f, 0.0);
 
-        return convertToWorld(head, glm::vec2(0.0f, 0.0f), lateral + braking);
+        return frame.toWorld(glm::vec2(0.0f, 0.0f), lateral + braking);
     }
 
     return glm::vec2(0.0, 0.0);
@@ -207,53 +270,68 @@ glm::vec2 SteeringManager::obstacleAvoiding() {
 }
 
 glm::vec2 SteeringManager::wallAvoidance() {
-    Transform& transform = m_registry->get<Transform>(m_owner);
-    Physics& physics = m_registry->get<Physics>(m_owner);
+    SteeringContext context(*m_registry, m_owner, entt::null);
+    return sp::wallAvoidance(context);
+}
 
-    glm::vec2 head = safeNormalize(physics.velocity);
+glm::vec2 sp::wallAvoidance(SteeringContext& context) {
+    TRACE_SCOPE("wallAvoidance", "behaviour");
 
-    if(head.x * head.x + head.y * head.y < 0.01f) {
-        head = orientationToVec(transform.angle);
-    }
+    const Transform& transform = context.transform;
+    const LocalFrame& frame = context.frame;
 
     const static float lineLength = 80.0f;
 
-    std::vector<Line2D> lines;
-    for(int i = 0; i < 6; ++i) {
-        Line2D line;
-        line.start = glm::vec2(0.0f, 0.0f) + transform.position;
-        line.end = lineLength * glm::vec2(std::cos(-M_PI * 0.375f + M_PI * 0.125f * i),
-                                          std::sin(-M_PI * 0.375f + M_PI * 0.125f * i));
-        line.end = convertToWorld(head, transform.position, line.end);
+    // Feeler ends in the local frame, from -67.5 to 62.5 degrees
+    static const auto localEnds = []() {
+        std::array<glm::vec2, 6> ends;
+        for(int i = 0; i < 6; ++i) {
+            ends[i] = lineLength * glm::vec2(std::cos(-M_PI * 0.375f + M_PI * 0.125f * i),
+                                             std::sin(-M_PI * 0.375f + M_PI * 0.125f * i));
+        }
+        return ends;
+    }();
 
-        lines.push_back(line);
+    glm::vec2 ends[6];
+    frame.toWorld(transform.position, Span<const glm::vec2>(localEnds.data(), localEnds.size()), ends);
+
+    Line2D feelers[6];
+    for(int i = 0; i < 6; ++i) {
+        feelers[i].start = transform.position;
+        feelers[i].end = ends[i];
     }
 
     float closestDistance = 32000.0f;
     float penetrationDepth = 0.0f;
     glm::vec2 wallNormal = glm::vec2(0.0f, 0.0f);
 
-    auto wallsView = m_registry->view<Wall>();
-    for(auto line : lines) {
-        wallsView.each([&](entt::entity entity, Wall& wall){
-            IntersectionResult result;
-            if(testLineIntersection2D(wall.line, line, result)) {
-                //std::cout << result.t1 << " " << result.t2 << "\n";
-                if(result.t1 >= 0.0f && result.t1 <= 1.0f &&
-                   result.t2 >= 0.0f && result.t2 <= 1.0f) {
-
-                    float distance = glm::distance(transform.position, result.point);
+    if(const WallBVH* bvh = context.registry.try_ctx<WallBVH>(); bvh) {
+        for(const auto& feeler: feelers) {
+            WallBVH::RayHit hit;
+            if(bvh->rayCast(feeler, hit) && hit.distance < closestDistance) {
+                penetrationDepth = lineLength - hit.distance;
+                wallNormal = hit.normal;
+                closestDistance = hit.distance;
+            }
+        }
+    } else {
+        // Wall by wall, with the same arithmetic as the BVH leaves
+        auto wallsView = context.registry.view<Wall>();
+        for(const auto& feeler: feelers) {
+            float feelerLength = glm::length(feeler.end - feeler.start);
+            wallsView.each([&](entt::entity entity, Wall& wall) {
+                glm::vec2 direction = wall.line.end - wall.line.start;
+                float t;
+                if(rayCastSegment(wall.line.start.x, wall.line.start.y, direction.x, direction.y, feeler, t)) {
+                    float distance = t * feelerLength;
                     if(distance < closestDistance) {
                         penetrationDepth = lineLength - distance;
                         wallNormal = wall.normal;
                         closestDistance = distance;
                     }
-
                 }
-            }
-
-
-        });
+            });
+        }
     }
 
     if(closestDistance < lineLength) {
@@ -284,84 +362,106 @@ glm::vec2 SteeringManager::interpose(entt::entity targetA, entt::entity targetB)
 
 
 glm::vec2 SteeringManager::hide(entt::entity target) {
+    SteeringContext context(*m_registry, m_owner, target);
+    return sp::hide(context);
+}
 
-    Transform& playerTransform = m_registry->get<Transform>(m_owner);
-    Transform& targetTransform = m_registry->get<Transform>(target);
+static glm::vec2 findHidingSpot(glm::vec2 obstaclePosition, float obstacleRadius, glm::vec2 targetPosition) {
+    glm::vec2 direction = safeNormalize(obstaclePosition - targetPosition);
 
-    auto obstaclesView = m_registry->view<Obstacle, Transform, Physics>();
+    return obstaclePosition + direction * (HIDING_SPOT_OFFSET + obstacleRadius);
+}
+
+glm::vec2 sp::hide(SteeringContext& context) {
+    TRACE_SCOPE("hide", "behaviour");
+
+    //Hiding spots further than that are useless - we evade instead
+    const static float maxHidingDistance = 1000.0f;
+
+    const Transform& playerTransform = context.transform;
+    const Transform& targetTransform = context.registry.get<Transform>(context.target);
 
     float closestDistance = 32000.0f;
     glm::vec2 closestPoint = glm::vec2(0.0f, 0.0f);
 
-    obstaclesView.each([&](entt::entity entity, Obstacle& obstacle, Transform& transform, Physics& physics){
-        if(entity == m_owner || entity == target) {
+    auto testObstacle = [&](entt::entity entity, glm::vec2 obstaclePosition, float obstacleRadius) {
+        if(entity == context.owner || entity == context.target) {
             return;
         }
 
-        glm::vec2 hidingSpot = findHidingSpot(transform.position, physics.radius, targetTransform.position);
+        glm::vec2 hidingSpot = findHidingSpot(obstaclePosition, obstacleRadius, targetTransform.position);
         float distance = glm::distance(hidingSpot, playerTransform.position);
         if(distance < closestDistance) {
             closestDistance = distance;
             closestPoint = hidingSpot;
         }
+    };
+
+    if(const ObstacleGrid* grid = context.registry.try_ctx<ObstacleGrid>(); grid) {
+        // A hiding spot is at most HIDING_SPOT_OFFSET + radius away from its obstacle
+        float maxOffset = HIDING_SPOT_OFFSET + grid->getMaxRadius();
+
+        grid->searchOutward(playerTransform.position, maxHidingDistance + maxOffset,
+            [&](const SpatialHashGrid::Item& item) {
+                testObstacle(item.entity, item.position, item.radius);
+            },
+            [&](float ringDistance) {
+                return ringDistance - maxOffset < closestDistance;
+            });
+    } else {
+        auto obstaclesView = context.registry.view<Obstacle, Transform, Physics>();
+        obstaclesView.each([&](entt::entity entity, Obstacle& obstacle, Transform& transform, Physics& physics){
+            testObstacle(entity, transform.position, physics.radius);
+        });
+    }
 
-    });
-
-    if(closestDistance > 1000.0f) {
-        return evade(target);
+    if(closestDistance > maxHidingDistance) {
+        return sk::evade(playerTransform.position, context.physics.velocity, context.physics.maxSpeed,
+                         targetTransform.position, context.registry.get<Physics>(context.target).velocity);
     }
 
-    return arrive(closestPoint, FAST);
+    return sk::arrive(playerTransform.position, context.physics.velocity, closestPoint, SteeringManager::FAST);
 }
 
 glm::vec2 SteeringManager::followPath() {
-    glm::vec2 currentWaypoint = m_path.getCurrentWaypoint();
-    if(m_path.isFinished()) {
-        return arrive(currentWaypoint, FAST);
-    }
-
-    Transform& playerTransform = m_registry->get<Transform>(m_owner);
-    if(glm::distance(playerTransform.position, currentWaypoint) < m_path.getWaypointThreshold()) {
-        currentWaypoint = m_path.nextWaypoint();
-    }
-
-    return seek(currentWaypoint);
+    SteeringContext context(*m_registry, m_owner, entt::null);
+    return sp::followPath(context);
 }
 
-glm::vec2 SteeringManager::offsetPursuit(entt::entity target, glm::vec2 offset) {
-
-    Transform& playerTransform = m_registry->get<Transform>(m_owner);
-    Physics& playerPhysics = m_registry->get<Physics>(m_owner);
-
-    Transform& targetTransform = m_registry->get<Transform>(target);
-    Physics& targetPhysics = m_registry->get<Physics>(target);
+glm::vec2 sp::followPath(SteeringContext& context) {
+    WaypointsPath* path = context.registry.try_get<WaypointsPath>(context.owner);
+    if(path == nullptr) {
+        return glm::vec2(0.0f, 0.0f);
+    }
 
-    glm::vec2 head = targetPhysics.velocity;
-    float length = glm::length(head);
-    if(length < 0.01f) {
-        head = orientationToVec(targetTransform.angle);
-    } else {
-        head *= (1.0f / length);
+    glm::vec2 currentWaypoint = path->getCurrentWaypoint();
+    if(path->isFinished()) {
+        return sk::arrive(context.transform.position, context.physics.velocity, currentWaypoint, SteeringManager::FAST);
     }
 
-    glm::vec2 globalOffset = convertToWorld(head, targetTransform.position, offset);
-    float arriveTime = glm::distance(playerTransform.position, globalOffset) / playerPhysics.maxSpeed;
+    if(glm::distance(context.transform.position, currentWaypoint) < path->getWaypointThreshold()) {
+        currentWaypoint = path->nextWaypoint();
+    }
 
-    return arrive(globalOffset + targetPhysics.velocity * arriveTime, FAST);
+    return sk::seek(context.transform.position, context.physics.velocity, context.physics.maxSpeed, currentWaypoint);
 }
 
-void SteeringManager::setPath(const WaypointsPath& path) {
-    m_path = path;
+glm::vec2 SteeringManager::offsetPursuit(entt::entity target, glm::vec2 offset) {
+    SteeringContext context(*m_registry, m_owner, target);
+    return sp::offsetPursuit(context, offset);
 }
 
-glm::vec2 SteeringManager::findHidingSpot(glm::vec2 obstaclePosition,
-                                          float obstacleRadius,
-                                          glm::vec2 targetPosition) {
-    const static float distanceFromObstacle = 30.0f;
+glm::vec2 sp::offsetPursuit(SteeringContext& context, glm::vec2 offset) {
+    TRACE_SCOPE("offsetPursuit", "behaviour");
+
+    Transform& targetTransform = context.registry.get<Transform>(context.target);
+    Physics& targetPhysics = context.registry.get<Physics>(context.target);
 
-    glm::vec2 direction = glm::normalize(obstaclePosition - targetPosition);
+    glm::vec2 globalOffset = getLocalFrame(context.registry, context.target).toWorld(targetTransform.position, offset);
+    float arriveTime = glm::distance(context.transform.position, globalOffset) / context.physics.maxSpeed;
 
-    return obstaclePosition + direction * (distanceFromObstacle + obstacleRadius);
+    return sk::arrive(context.transform.position, context.physics.velocity,
+                      globalOffset + targetPhysics.velocity * arriveTime, SteeringManager::FAST);
 }
 
 float vecToOrientation(glm::vec2 vector) {
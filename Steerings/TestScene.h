@@ -3,6 +3,7 @@
 
 #include "GameManager.h"
 #include "TextureManager.h"
+#include "ScenarioGenerator.h"
 
 #include <set>
 
@@ -23,15 +24,35 @@ entt::entity createDrawableEntity(entt::registry& registry, const string& textur
 
 class TestScene: public GameManager {
 public:
+    TestScene(): m_useScenario(false), m_useLOD(false) { }
+
+    // Generated world instead of the hand-placed one, has to be set before init()
+    void setScenario(const ScenarioConfig& config) {
+        m_scenario = config;
+        m_useScenario = true;
+    }
+
+    // AISteeringSystem level of detail, has to be set before init()
+    void setLOD(const SteeringLODSettings& settings) {
+        m_lod = settings;
+        m_useLOD = true;
+    }
+
     virtual bool init(const string& programName, int width, int height) {
         if(!GameManager::init(programName, width, height)) return false;
 
-        TextureManager::getInstance().setRenderer(m_prenderer);
+        if(!isHeadless()) {
+            TextureManager::getInstance().setRenderer(m_prenderer);
+        }
 
         initContext();
         initSystems();
-        initEntities();
-        initWalls();
+        if(m_useScenario) {
+            initScenario();
+        } else {
+            initEntities();
+            initWalls();
+        }
 
         m_systemsManager.getDispatcher().sink<MouseEvent>().connect<&TestScene::onMouseEvent>(*this);
 
@@ -47,18 +68,53 @@ public:
 
         gameData.screenSize = glm::vec2(m_screenWidth, m_screenHeight);
 
+        if(m_useLOD) {
+            registry.set<SteeringLODSettings>(m_lod);
+        }
     }
 
     void initSystems() {
-        m_systemsManager.addSystem(make_shared<RenderingSystem>(m_prenderer));
-        m_systemsManager.addSystem(make_shared<PathRenderingSystem>(m_prenderer));
-        m_systemsManager.addSystem(make_shared<ObstacleRenderingSystem>(m_prenderer));
-        m_systemsManager.addSystem(make_shared<WallRenderingSystem>(m_prenderer));
-        m_systemsManager.addSystem(make_shared<ObstacleBoxRenderingSystem>(m_prenderer));
+        if(!isHeadless()) {
+            m_systemsManager.addSystem(make_shared<TransformInterpolationSystem>(), SystemPhase::RENDERING);
+            m_systemsManager.addSystem(make_shared<RenderingSystem>(m_prenderer), SystemPhase::RENDERING);
+            m_systemsManager.addSystem(make_shared<PathRenderingSystem>(m_prenderer), SystemPhase::RENDERING);
+            m_systemsManager.addSystem(make_shared<ObstacleRenderingSystem>(m_prenderer), SystemPhase::RENDERING);
+            m_systemsManager.addSystem(make_shared<WallRenderingSystem>(m_prenderer), SystemPhase::RENDERING);
+            m_systemsManager.addSystem(make_shared<ObstacleBoxRenderingSystem>(m_prenderer), SystemPhase::RENDERING);
+
+            m_systemsManager.addSystem(make_shared<TransformSnapshotSystem>());
+        }
+
         m_systemsManager.addSystem(make_shared<PhysicsSystem>());
+        m_systemsManager.addSystem(make_shared<ObstacleGridSystem>());
+        m_systemsManager.addSystem(make_shared<WallBVHSystem>());
+        m_systemsManager.addSystem(make_shared<LocalFrameSystem>());
         m_systemsManager.addSystem(make_shared<AISteeringSystem>());
     }
 
+    void initScenario() {
+        entt::registry& registry = m_systemsManager.getRegistry();
+
+        ScenarioGenerator generator(m_scenario);
+        generator.setEntityFactory([this](entt::registry&, glm::vec2 position) {
+            return createEntity("Resources/Pointer.png", position);
+        });
+
+        ScenarioStats stats = generator.generate(registry);
+        registry.ctx<GameData>().screenSize = glm::vec2(stats.worldSize, stats.worldSize);
+
+        // There is no player in a generated world, levels are by distance from its center
+        if(SteeringLODSettings* lod = registry.try_ctx<SteeringLODSettings>(); lod) {
+            lod->focus = glm::vec2(stats.worldSize, stats.worldSize) * 0.5f;
+        }
+
+        m_markEntity = createEntity("Resources/Mark.png", glm::vec2(200, 200));
+
+        printf("Scenario %u: %.0fx%.0f world, %zu leaders, %zu followers, %zu chasers, %zu obstacles, %zu walls\n",
+               m_scenario.seed, stats.worldSize, stats.worldSize, stats.leaders, stats.followers, stats.chasers,
+               stats.obstacles, stats.walls);
+    }
+
     void initWalls() {
         entt::registry& registry = m_systemsManager.getRegistry();
 
@@ -92,12 +148,12 @@ public:
 //        }
 
 
-        entt::entity playerEntity = createDrawableEntity(registry, "Resources/Pointer.png", glm::vec2(0, 0));
+        entt::entity playerEntity = createEntity("Resources/Pointer.png", glm::vec2(0, 0));
         registry.assign<Physics>(playerEntity, 300.0f, 1.0f, 600.0f, 100.0f, 20.0f);
         registry.assign<Controllable>(playerEntity);
         registry.assign<Obstacle>(playerEntity, SDL_Color{0, 255, 0, 255});
 
-        m_markEntity = createDrawableEntity(registry, "Resources/Mark.png", glm::vec2(200, 200));
+        m_markEntity = createEntity("Resources/Mark.png", glm::vec2(200, 200));
 
         Waypoints waypoints = {
             glm::vec2(50.0f, 50.0f),
@@ -112,24 +168,24 @@ public:
             glm::vec2(50.0f, 350.0f)
         };
 
-        entt::entity shipEntity = createDrawableEntity(registry, "Resources/Pointer.png", glm::vec2(240.0f, 180.0f));
+        entt::entity shipEntity = createEntity("Resources/Pointer.png", glm::vec2(240.0f, 180.0f));
         registry.assign<Physics>(shipEntity, 150.0f, 1.0f, 200.0f, 100.0f, 20.0f);
 
-        auto smanager = make_shared<SteeringManager>(&m_systemsManager.getRegistry(), shipEntity);
-        smanager->target = playerEntity;
-        smanager->setPath(WaypointsPath(waypoints, 25.0f, true));
-        registry.assign<AI>(shipEntity, smanager);
+        registry.assign<AI>(shipEntity, playerEntity);
+        registry.assign<WaypointsPath>(shipEntity, waypoints, 25.0f, true);
 
 
-        entt::entity shipEntity2 = createDrawableEntity(registry, "Resources/Pointer.png", glm::vec2(0.0f, 0.0f));
+        entt::entity shipEntity2 = createEntity("Resources/Pointer.png", glm::vec2(0.0f, 0.0f));
         registry.assign<Physics>(shipEntity2, 150.0f, 1.0f, 200.0f, 100.0f, 20.0f);
 
-        auto smanager2 = make_shared<SteeringManager>(&m_systemsManager.getRegistry(), shipEntity2);
-        smanager2->target = shipEntity;
-        registry.assign<AI>(shipEntity2, smanager2);
+        registry.assign<AI>(shipEntity2, shipEntity);
     }
 
-    virtual void update(float delta) {
+    // Input goes after the step: TransformSnapshotSystem has already recorded PreviousTransform, so the
+    // player's turns are interpolated like its movement
+    virtual void simulate(float delta) {
+        m_systemsManager.simulate(delta);
+
         auto& registry = m_systemsManager.getRegistry();
         entt::entity player = entt::null;
 
@@ -161,14 +217,32 @@ public:
             if(!moving)
                 playerPhysics.velocity -= playerPhysics.velocity * 2.0f * delta;
         }
+    }
+
+    virtual void render(float alpha, float delta) {
+        if(isHeadless()) return;
+
         SDL_SetRenderDrawColor(m_prenderer, 0xFF, 0xFF, 0xFF, 0xFF);
         SDL_RenderClear(m_prenderer);
 
-        m_systemsManager.update(delta);
+        m_systemsManager.render(alpha, delta);
 
         SDL_RenderPresent(m_prenderer);
     }
 
+    // Without a renderer there are no textures, headless entities get a Transform of the pointer size
+    entt::entity createEntity(const string& textureName, glm::vec2 position) {
+        entt::registry& registry = m_systemsManager.getRegistry();
+        if(!isHeadless()) {
+            return createDrawableEntity(registry, textureName, position);
+        }
+
+        entt::entity entity = registry.create();
+        registry.assign<Transform>(entity, position, glm::vec2(32.0f, 32.0f), 1.0f, 0.0f);
+
+        return entity;
+    }
+
     void onMouseEvent(const MouseEvent& event) {
         Transform& transform = m_systemsManager.getRegistry().get<Transform>(m_markEntity);
         transform.position = glm::vec2(event.event.x, event.event.y);
@@ -184,6 +258,11 @@ public:
 
     void input(SDL_Event event) {
         if(event.key.type == SDL_KEYDOWN) {
+            // T records a trace of the next 300 frames
+            if(event.key.keysym.sym == SDLK_t && event.key.repeat == 0 && !Tracer::getInstance().isRecording()) {
+                Tracer::getInstance().capture(300, "trace.json");
+            }
+
             m_pressedKeys.emplace(event.key.keysym.sym);
         } else if(event.key.type == SDL_KEYUP) {
             m_pressedKeys.erase(event.key.keysym.sym);
@@ -192,6 +271,12 @@ public:
 private:
     set<SDL_Keycode> m_pressedKeys;
     entt::entity m_markEntity;
+
+    ScenarioConfig m_scenario;
+    bool m_useScenario;
+
+    SteeringLODSettings m_lod;
+    bool m_useLOD;
 };
 
 
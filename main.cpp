@@ -1,16 +1,118 @@
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
 #include "SDL2/SDL.h"
 
 #include "Steerings/TestScene.h"
 
-int main() {
+const char* USAGE = "Usage: %s [--fixed-rate HZ] [--pacing vsync|sleep|unthrottled] [--fps N]\n"
+                    "       [--headless [--ticks N] [--duration SECONDS]]\n"
+                    "       [--trace FILE [--trace-frames N]]\n"
+                    "       [--scenario AGENTS [--seed N]]\n"
+                    "       [--lod BUDGET_MICROSECONDS]\n"
+#ifdef AI_PROFILE_SYSTEMS
+                    "       [--stats-csv FILE [--stats-every STEPS]]\n"
+#endif
+                    ;
+
+int main(int argc, char* argv[]) {
+    bool headless = false;
+    uint64_t ticksCount = 0;
+    double durationSeconds = 0.0;
+    float fixedRate = 0.0f;
+    PacingMode pacing = PacingMode::SLEEP;
+    double targetFps = 60.0;
+    ScenarioConfig scenario;
+    bool useScenario = false;
+    SteeringLODSettings lod;
+    bool useLOD = false;
+    const char* traceFile = nullptr;
+    std::size_t traceFrames = 300;
+#ifdef AI_PROFILE_SYSTEMS
+    const char* statsFile = nullptr;
+    std::size_t statsPeriod = 60;
+#endif
+
+    for(int i = 1; i < argc; ++i) {
+        if(std::strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if(std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            ticksCount = std::strtoull(argv[++i], NULL, 10);
+        } else if(std::strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            durationSeconds = std::atof(argv[++i]);
+        } else if(std::strcmp(argv[i], "--fixed-rate") == 0 && i + 1 < argc) {
+            fixedRate = std::atof(argv[++i]);
+        } else if(std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            targetFps = std::atof(argv[++i]);
+#ifdef AI_PROFILE_SYSTEMS
+        } else if(std::strcmp(argv[i], "--stats-csv") == 0 && i + 1 < argc) {
+            statsFile = argv[++i];
+        } else if(std::strcmp(argv[i], "--stats-every") == 0 && i + 1 < argc) {
+            statsPeriod = std::strtoull(argv[++i], NULL, 10);
+#endif
+        } else if(std::strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            scenario.agentsCount = std::strtoull(argv[++i], NULL, 10);
+            useScenario = true;
+        } else if(std::strcmp(argv[i], "--lod") == 0 && i + 1 < argc) {
+            lod.budgetMicroseconds = std::atof(argv[++i]);     // 0 = levels only, no budget
+            useLOD = true;
+        } else if(std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            scenario.seed = std::strtoul(argv[++i], NULL, 10);
+        } else if(std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            traceFile = argv[++i];
+        } else if(std::strcmp(argv[i], "--trace-frames") == 0 && i + 1 < argc) {
+            traceFrames = std::strtoull(argv[++i], NULL, 10);
+        } else if(std::strcmp(argv[i], "--pacing") == 0 && i + 1 < argc) {
+            const char* mode = argv[++i];
+            if(std::strcmp(mode, "vsync") == 0) pacing = PacingMode::VSYNC;
+            else if(std::strcmp(mode, "sleep") == 0) pacing = PacingMode::SLEEP;
+            else if(std::strcmp(mode, "unthrottled") == 0) pacing = PacingMode::UNTHROTTLED;
+            else {
+                printf(USAGE, argv[0]);
+                return 1;
+            }
+        } else {
+            printf(USAGE, argv[0]);
+            return 1;
+        }
+    }
+
+    // Headless run without any limit would never end
+    if(headless && ticksCount == 0 && durationSeconds <= 0.0) {
+        ticksCount = 10000;
+    }
+
+    if(traceFile != nullptr) Tracer::getInstance().capture(traceFrames, traceFile);
 
     TestScene scene;
+    scene.setHeadless(headless);
+    if(useScenario) scene.setScenario(scenario);
+    if(useLOD) scene.setLOD(lod);
+    scene.setFixedTimestep(fixedRate);
+    scene.setFramePacing(pacing, targetFps);
     if(scene.init("TestScene", 640, 480)) {
-        scene.run();
+#ifdef AI_PROFILE_SYSTEMS
+        if(statsFile != nullptr && !scene.getSystemsManager().setStatsDump(statsFile, statsPeriod)) {
+            printf("Can't open %s\n", statsFile);
+        }
+#endif
+
+        if(headless) {
+            scene.runHeadless(ticksCount, durationSeconds, (fixedRate > 0.0f) ? 1.0f / fixedRate : 1.0f / 60.0f);
+        } else {
+            scene.run();
+            scene.getFramePacer().printStats();
+        }
+
+#ifdef AI_PROFILE_SYSTEMS
+        printf("%-28s %-10s %10s %10s %10s %10s %10s\n", "system", "phase", "min(ms)", "mean(ms)", "p99(ms)", "max(ms)", "entities");
+        for(const auto& stats: scene.getSystemsManager().getSystemStats()) {
+            printf("%-28s %-10s %10.3f %10.3f %10.3f %10.3f %10zu\n", stats.name, stats.phase,
+                   stats.min, stats.mean, stats.p99, stats.max, stats.entities);
+        }
+#endif
     }
 
 
     return 0;
 }
-